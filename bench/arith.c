@@ -0,0 +1,30 @@
+// Integer arithmetic: the total number of Collatz steps of 1..N.
+
+#include <stdint.h>
+
+void print(const char* message, int64_t length);
+
+int64_t steps(int64_t start) {
+    int64_t n = start;
+    int64_t count = 0;
+    while (n != 1) {
+        if (n % 2 == 0) {
+            n = n / 2;
+        } else {
+            n = 3 * n + 1;
+        }
+        count = count + 1;
+    }
+    return count;
+}
+
+int main(void) {
+    int64_t total = 0;
+    for (int64_t i = 1; i < 1000000; ++i) {
+        total = total + steps(i);
+    }
+    if (total != 131434272) {
+        print("wrong result", 12);
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+// Call-heavy code: the naive recursive Fibonacci function.
+
+#include <stdint.h>
+
+void print(const char* message, int64_t length);
+
+int64_t fib(int64_t n) {
+    if (n < 2) {
+        return n;
+    }
+    return fib(n - 1) + fib(n - 2);
+}
+
+int main(void) {
+    if (fib(35) != 9227465) {
+        print("wrong result", 12);
+    }
+    return 0;
+}
@@ -0,0 +1,13 @@
+// String output: two million calls into the runtime's 'print'.
+
+#include <stdint.h>
+
+void print(const char* message, int64_t length);
+
+int main(void) {
+    static const char line[] = "The quick brown fox jumps over the lazy dog";
+    for (int64_t i = 0; i < 2000000; ++i) {
+        print(line, sizeof(line) - 1);
+    }
+    return 0;
+}
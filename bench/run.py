@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Runs the kernels in this directory compiled by sac and by a C compiler.
+
+Each kernel is a pair of files, name.sa and name.c, that do the same work.
+Both are linked against the sa runtime, so a kernel's two versions differ
+only in the code the two compilers generate for them. The report gives
+the best of several runs of each and the ratio sa / C. A ratio above 1
+means the sa version is slower. Before it is timed, the sa version's
+output is checked against the C version's, so a miscompiled kernel fails
+rather than being reported as fast.
+
+Usually run through the 'bench' target, which passes the paths of the
+freshly built sac and runtime:
+
+    cmake --build build --target bench
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+import time
+
+BENCH_DIR = os.path.dirname(os.path.abspath(__file__))
+
+
+def kernels():
+    names = sorted(f[:-3] for f in os.listdir(BENCH_DIR) if f.endswith(".sa"))
+    return [n for n in names if os.path.exists(os.path.join(BENCH_DIR, n + ".c"))]
+
+
+def run_checked(args):
+    result = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if result.returncode != 0:
+        sys.exit("error: '%s' failed:\n%s" % (" ".join(args), result.stdout))
+
+
+def build(name, args):
+    """Builds the sa and the C version of a kernel; returns both executables."""
+    sa_source = os.path.join(BENCH_DIR, name + ".sa")
+    c_source = os.path.join(BENCH_DIR, name + ".c")
+    sa_object = os.path.join(args.build_dir, name + ".sa.o")
+    sa_exe = os.path.join(args.build_dir, name + ".sa.exe")
+    c_exe = os.path.join(args.build_dir, name + ".c.exe")
+
+    # sac writes the object; the C compiler driver links it, so both
+    # executables get the same start-up files and libraries.
+    run_checked([args.sac, "--target=" + args.triple] + args.sac_flags.split() +
+                ["--emit=obj", "-o", sa_object, sa_source])
+    run_checked([args.cc, sa_object, args.runtime, "-lpthread", "-o", sa_exe])
+    run_checked([args.cc] + args.cflags.split() + [c_source, args.runtime, "-lpthread", "-o", c_exe])
+    return sa_exe, c_exe
+
+
+def check_output(sa_exe, c_exe):
+    """Fails unless the sa version prints what the C version prints."""
+    outputs = []
+    for exe in (sa_exe, c_exe):
+        result = subprocess.run([exe], stdout=subprocess.PIPE, stderr=subprocess.PIPE, text=True)
+        if result.returncode != 0:
+            sys.exit("error: '%s' exited with %d:\n%s" % (exe, result.returncode, result.stderr))
+        outputs.append(result.stdout)
+    if outputs[0] != outputs[1]:
+        sys.exit("error: '%s' printed\n%s\nbut the C version printed\n%s"
+                 % (sa_exe, outputs[0], outputs[1]))
+
+
+def measure(exe, repeat):
+    """The best wall-clock time of 'repeat' runs, in seconds."""
+    best = None
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = subprocess.run([exe], stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, text=True)
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            sys.exit("error: '%s' exited with %d:\n%s" % (exe, result.returncode, result.stderr))
+        best = elapsed if best is None else min(best, elapsed)
+    return best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--sac", required=True, help="the sac executable")
+    parser.add_argument("--runtime", required=True, help="libsa_runtime.a")
+    parser.add_argument("--cc", default="clang", help="the C compiler (default: clang)")
+    parser.add_argument("--sac-flags", default="-O2",
+                        help="flags for the sa versions (default: -O2)")
+    parser.add_argument("--cflags", default="-O2", help="flags for the C versions (default: -O2)")
+    parser.add_argument("--build-dir", default="bench-build", help="where to put the executables")
+    parser.add_argument("--repeat", type=int, default=5, help="runs per executable (default: 5)")
+    parser.add_argument("--max-ratio", type=float,
+                        help="fail if any kernel's sa / C ratio is above this")
+    parser.add_argument("kernel", nargs="*", help="the kernels to run (default: all)")
+    args = parser.parse_args()
+
+    # sac targets macOS unless told otherwise; compile for what the C
+    # compiler targets, which is what the executables are linked for.
+    args.triple = subprocess.run([args.cc, "-dumpmachine"], stdout=subprocess.PIPE,
+                                 text=True, check=True).stdout.strip()
+    os.makedirs(args.build_dir, exist_ok=True)
+
+    names = args.kernel or kernels()
+    print("sa: %s %s, C: %s %s" % (os.path.basename(args.sac), args.sac_flags,
+                                   os.path.basename(args.cc), args.cflags))
+    print("%-16s %10s %10s %8s" % ("kernel", "sa (ms)", "C (ms)", "sa / C"))
+    worst = 0.0
+    for name in names:
+        sa_exe, c_exe = build(name, args)
+        check_output(sa_exe, c_exe)
+        sa_time = measure(sa_exe, args.repeat)
+        c_time = measure(c_exe, args.repeat)
+        ratio = sa_time / c_time
+        worst = max(worst, ratio)
+        print("%-16s %10.1f %10.1f %8.2f" % (name, sa_time * 1000, c_time * 1000, ratio))
+
+    if args.max_ratio is not None and worst > args.max_ratio:
+        sys.exit("error: a kernel is %.2fx slower than C, more than the allowed %.2fx"
+                 % (worst, args.max_ratio))
+
+
+if __name__ == "__main__":
+    main()
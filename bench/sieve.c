@@ -0,0 +1,33 @@
+// Array indexing: the sieve of Eratosthenes, run ten times.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+void print(const char* message, int64_t length);
+
+int64_t count_primes(void) {
+    bool composite[1000000];
+    memset(composite, 0, sizeof(composite));
+    int64_t count = 0;
+    for (int64_t i = 2; i < 1000000; ++i) {
+        if (composite[i] == false) {
+            count = count + 1;
+            int64_t j = i * i;
+            while (j < 1000000) {
+                composite[j] = true;
+                j = j + i;
+            }
+        }
+    }
+    return count;
+}
+
+int main(void) {
+    for (int64_t round = 0; round < 10; ++round) {
+        if (count_primes() != 78498) {
+            print("wrong result", 12);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,163 @@
+// alloc.c
+//
+// Implementation of the runtime allocator declared in alloc.h.
+#include "alloc.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void* checked_malloc(size_t size) {
+    void* ptr = malloc(size);
+    if (!ptr) {
+        fputs("sa runtime: out of memory\n", stderr);
+        abort();
+    }
+    return ptr;
+}
+
+// --- Regions ---
+
+struct sa_region_chunk {
+    sa_region_chunk* next;
+    char* limit; // One past the last usable byte.
+    _Alignas(16) char data[];
+};
+
+// The usable size of a standard chunk. Requests that do not fit into an
+// empty standard chunk get a chunk of their own.
+#define SA_CHUNK_SIZE (64 * 1024 - sizeof(sa_region_chunk))
+
+// Chunks released by exited regions, reused before asking malloc again.
+static _Thread_local sa_region_chunk* free_chunks;
+
+// The innermost region of this thread, and the one used outside of any
+// 'region' block, which is never released.
+static _Thread_local sa_region* current_region;
+static _Thread_local sa_region thread_region;
+
+static sa_region_chunk* chunk_new(size_t size) {
+    sa_region_chunk* chunk = checked_malloc(sizeof(sa_region_chunk) + size);
+    chunk->next = NULL;
+    chunk->limit = chunk->data + size;
+    return chunk;
+}
+
+void sa_region_enter(sa_region* region) {
+    region->chunks = NULL;
+    region->oldest = NULL;
+    region->large = NULL;
+    region->cursor = NULL;
+    region->parent = current_region;
+    current_region = region;
+}
+
+void sa_region_exit(sa_region* region) {
+    if (region->chunks) {
+        region->oldest->next = free_chunks;
+        free_chunks = region->chunks;
+    }
+    for (sa_region_chunk* chunk = region->large; chunk;) {
+        sa_region_chunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    current_region = region->parent;
+}
+
+void* sa_region_alloc(sa_region* region, size_t size, size_t align) {
+    if (region->chunks) {
+        uintptr_t p = ((uintptr_t)region->cursor + (align - 1)) & ~(uintptr_t)(align - 1);
+        if (p + size <= (uintptr_t)region->chunks->limit) {
+            region->cursor = (char*)(p + size);
+            return (void*)p;
+        }
+    }
+
+    if (size + align > SA_CHUNK_SIZE) {
+        sa_region_chunk* chunk = chunk_new(size + align);
+        chunk->next = region->large;
+        region->large = chunk;
+        uintptr_t p = ((uintptr_t)chunk->data + (align - 1)) & ~(uintptr_t)(align - 1);
+        return (void*)p;
+    }
+
+    sa_region_chunk* chunk = free_chunks;
+    if (chunk) {
+        free_chunks = chunk->next;
+    } else {
+        chunk = chunk_new(SA_CHUNK_SIZE);
+    }
+    chunk->next = region->chunks;
+    if (!region->chunks) {
+        region->oldest = chunk;
+    }
+    region->chunks = chunk;
+
+    uintptr_t p = ((uintptr_t)chunk->data + (align - 1)) & ~(uintptr_t)(align - 1);
+    region->cursor = (char*)(p + size);
+    return (void*)p;
+}
+
+sa_region* sa_current_region(void) {
+    return current_region;
+}
+
+void* sa_alloc(size_t size) {
+    sa_region* region = current_region ? current_region : &thread_region;
+    return sa_region_alloc(region, size, 16);
+}
+
+// --- Pools ---
+
+#define SA_POOL_MIN_SHIFT 4 // 16 bytes
+#define SA_POOL_CLASSES 8   // 16 .. 2048 bytes
+#define SA_POOL_SLAB_SIZE (64 * 1024)
+
+typedef struct sa_pool_object {
+    struct sa_pool_object* next;
+} sa_pool_object;
+
+static _Thread_local sa_pool_object* pool_free_lists[SA_POOL_CLASSES];
+
+static unsigned size_class(size_t size) {
+    unsigned cls = 0;
+    while (((size_t)1 << (cls + SA_POOL_MIN_SHIFT)) < size) {
+        ++cls;
+    }
+    return cls;
+}
+
+void* sa_pool_alloc(size_t size) {
+    if (size > SA_POOL_MAX_SIZE) {
+        return checked_malloc(size);
+    }
+
+    unsigned cls = size_class(size);
+    sa_pool_object* object = pool_free_lists[cls];
+    if (!object) {
+        // Carve a fresh slab into objects of this class. Slabs are never
+        // returned to malloc; freed objects stay in the pools.
+        size_t object_size = (size_t)1 << (cls + SA_POOL_MIN_SHIFT);
+        char* slab = checked_malloc(SA_POOL_SLAB_SIZE);
+        for (size_t offset = 0; offset + object_size <= SA_POOL_SLAB_SIZE; offset += object_size) {
+            sa_pool_object* o = (sa_pool_object*)(slab + offset);
+            o->next = object;
+            object = o;
+        }
+    }
+    pool_free_lists[cls] = object->next;
+    return object;
+}
+
+void sa_pool_free(void* ptr, size_t size) {
+    if (size > SA_POOL_MAX_SIZE) {
+        free(ptr);
+        return;
+    }
+
+    unsigned cls = size_class(size);
+    sa_pool_object* object = ptr;
+    object->next = pool_free_lists[cls];
+    pool_free_lists[cls] = object;
+}
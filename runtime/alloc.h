@@ -0,0 +1,49 @@
+// alloc.h
+//
+// The sa runtime allocator: bump-pointer regions for scoped allocation and
+// size-class pools for small objects with individual lifetimes.
+#pragma once
+
+#include <stddef.h>
+
+typedef struct sa_region_chunk sa_region_chunk;
+
+// A region hands out memory by bumping a pointer through a list of chunks
+// and releases all of it at once. Compiled code reserves one sa_region on
+// the stack for every 'region { ... }' block, so the layout is part of the
+// compiler ABI: five pointer-sized fields.
+typedef struct sa_region {
+    sa_region_chunk* chunks;    // Standard-size chunks, newest first.
+    sa_region_chunk* oldest;    // The tail of 'chunks', for O(1) release.
+    sa_region_chunk* large;     // Oversized allocations, one chunk each.
+    char* cursor;               // Next free byte in 'chunks'.
+    struct sa_region* parent;   // The enclosing region on this thread.
+} sa_region;
+
+// Makes 'region' the innermost region of the calling thread.
+void sa_region_enter(sa_region* region);
+
+// Releases everything allocated in 'region' and makes its parent current
+// again. Standard chunks go back to a per-thread cache in constant time.
+void sa_region_exit(sa_region* region);
+
+// Allocates from 'region'. 'align' must be a power of two.
+void* sa_region_alloc(sa_region* region, size_t size, size_t align);
+
+// The innermost region of the calling thread, or NULL outside of any
+// 'region' block.
+sa_region* sa_current_region(void);
+
+// Allocates 'size' bytes from the innermost region of the calling thread.
+// Outside of any region the memory lives until the thread exits.
+void* sa_alloc(size_t size);
+
+// Small-object pools with per-thread free lists, one per power-of-two size
+// class up to SA_POOL_MAX_SIZE; larger requests go to malloc. Objects must
+// be freed with the size they were allocated with. A freed object joins the
+// pool of the thread that frees it and the pools never shrink, so they only
+// suit objects that die on the thread that allocated them, like coroutine
+// frames on the event loop.
+#define SA_POOL_MAX_SIZE 2048
+void* sa_pool_alloc(size_t size);
+void sa_pool_free(void* ptr, size_t size);
@@ -0,0 +1,367 @@
+// async.c
+//
+// The event loop behind 'async fn' and 'await'.
+//
+// An async function is compiled into an LLVM coroutine. The loop knows
+// nothing about what a coroutine computes; it only keeps a queue of
+// handles that are ready to run and resumes them in order. A coroutine
+// that would block on a socket parks its handle on the descriptor with
+// sa_io_wait and suspends; when epoll reports the descriptor ready, the
+// handle goes back on the queue and the operation is retried. Everything
+// runs on the thread that called sa_async_run, so none of this is locked.
+//
+// Descriptors are registered edge-triggered for both directions once,
+// when they are created. That is enough because a coroutine only ever
+// waits after an operation failed with EAGAIN: any readiness after that
+// is a new edge.
+//
+// Linux only: epoll has no portable equivalent.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// What an I/O operation returns instead of blocking; the compiler waits
+// for the descriptor and calls it again. No byte count or -errno value
+// can be this.
+#define SA_IO_PENDING INT64_MIN
+
+// How much one 'read' returns at most.
+#define SA_IO_BUFFER_SIZE 4096
+
+// The compiler lowers coroutines with LLVM's switched-resume ABI: a handle
+// points at the frame, which starts with the function that resumes it.
+typedef void (*sa_resume_fn)(void*);
+
+static void sa_async_resume(void* handle) {
+    (*(sa_resume_fn*)handle)(handle);
+}
+
+static void* sa_checked_realloc(void* ptr, size_t size) {
+    void* p = realloc(ptr, size);
+    if (!p) {
+        fputs("sa runtime: out of memory\n", stderr);
+        abort();
+    }
+    return p;
+}
+
+// --- Ready queue ---
+// A ring buffer of handles, grown by doubling.
+
+static void** ready;
+static size_t ready_head;
+static size_t ready_count;
+static size_t ready_capacity;
+
+void sa_async_ready(void* handle) {
+    if (ready_count == ready_capacity) {
+        size_t capacity = ready_capacity ? ready_capacity * 2 : 256;
+        void** grown = sa_checked_realloc(NULL, capacity * sizeof(void*));
+        for (size_t i = 0; i < ready_count; ++i) {
+            grown[i] = ready[(ready_head + i) % ready_capacity];
+        }
+        free(ready);
+        ready = grown;
+        ready_head = 0;
+        ready_capacity = capacity;
+    }
+    ready[(ready_head + ready_count) % ready_capacity] = handle;
+    ++ready_count;
+}
+
+// --- Descriptors ---
+// What the loop knows about each open socket, indexed by descriptor.
+
+typedef struct sa_io_state {
+    void* reader;         // The coroutine waiting to read or accept.
+    void* writer;         // The coroutine waiting to write.
+    char* buffer;         // What the last 'read' returned, allocated on first use.
+                          // Kept when the descriptor is closed.
+    int64_t written;      // How much of the current 'write' is done.
+    int closing;          // Set by 'close' while woken waiters still use it.
+} sa_io_state;
+
+static sa_io_state* io_states;
+static size_t io_capacity;
+static int epoll_fd = -1;
+
+// The number of coroutines parked in sa_io_wait. The loop is done when it
+// has nothing ready and nothing waiting.
+static size_t waiting;
+
+// Descriptors 'close' could not close right away, because coroutines it
+// woke up still have to fail their operation on them. Closing them first
+// could hand the number to a new socket, which they would then use.
+static int64_t* closing_fds;
+static size_t closing_count;
+static size_t closing_capacity;
+
+static sa_io_state* sa_io_state_of(int64_t fd) {
+    if ((size_t)fd >= io_capacity) {
+        size_t capacity = io_capacity ? io_capacity : 1024;
+        while (capacity <= (size_t)fd) {
+            capacity *= 2;
+        }
+        io_states = sa_checked_realloc(io_states, capacity * sizeof(sa_io_state));
+        memset(io_states + io_capacity, 0, (capacity - io_capacity) * sizeof(sa_io_state));
+        io_capacity = capacity;
+    }
+    return &io_states[fd];
+}
+
+// Adds a new non-blocking descriptor to the loop. Returns 'fd', or -errno
+// after closing it.
+static int64_t sa_io_register(int fd) {
+    if (epoll_fd < 0) {
+        epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd < 0) {
+            perror("sa runtime: epoll_create1");
+            abort();
+        }
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = fd;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        int error = errno;
+        close(fd);
+        return -error;
+    }
+    sa_io_state_of(fd);
+    return fd;
+}
+
+void sa_io_wait(int64_t fd, int64_t writes, void* handle) {
+    sa_io_state* state = sa_io_state_of(fd);
+    if (writes) {
+        state->writer = handle;
+    } else {
+        state->reader = handle;
+    }
+    ++waiting;
+}
+
+// --- Sockets ---
+// Called from compiled code as 'listen', 'connect' and 'close'.
+
+static struct sockaddr_in sa_ipv4_address(uint32_t host, int64_t port) {
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(host);
+    address.sin_port = htons((uint16_t)port);
+    return address;
+}
+
+int64_t sa_tcp_listen(int64_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -errno;
+    }
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    struct sockaddr_in address = sa_ipv4_address(INADDR_ANY, port);
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        int error = errno;
+        close(fd);
+        return -error;
+    }
+    return sa_io_register(fd);
+}
+
+// Starts connecting to 'port' on this machine. The connection is ready
+// when the descriptor is first writable, which the first 'write' waits for.
+int64_t sa_tcp_connect(int64_t port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -errno;
+    }
+    struct sockaddr_in address = sa_ipv4_address(INADDR_LOOPBACK, port);
+    if (connect(fd, (struct sockaddr*)&address, sizeof(address)) < 0 && errno != EINPROGRESS) {
+        int error = errno;
+        close(fd);
+        return -error;
+    }
+    return sa_io_register(fd);
+}
+
+// The buffer stays: the last string read from 'fd' may still be in use,
+// and a later socket with the same number reuses it.
+static void sa_io_close_now(int64_t fd) {
+    if ((size_t)fd < io_capacity) {
+        char* buffer = io_states[fd].buffer;
+        memset(&io_states[fd], 0, sizeof(sa_io_state));
+        io_states[fd].buffer = buffer;
+    }
+    close((int)fd); // Also removes it from the epoll set.
+}
+
+static int sa_io_closing(int64_t fd) {
+    return (size_t)fd < io_capacity && io_states[fd].closing;
+}
+
+// Closes 'fd'. The coroutines waiting on it are woken up and their
+// operation fails with EBADF; the descriptor itself is closed once they
+// have run.
+void sa_io_close(int64_t fd) {
+    if (fd < 0 || sa_io_closing(fd)) {
+        return;
+    }
+    sa_io_state* state = (size_t)fd < io_capacity ? &io_states[fd] : NULL;
+    if (!state || (!state->reader && !state->writer)) {
+        sa_io_close_now(fd);
+        return;
+    }
+    if (state->reader) {
+        sa_async_ready(state->reader);
+        state->reader = NULL;
+        --waiting;
+    }
+    if (state->writer) {
+        sa_async_ready(state->writer);
+        state->writer = NULL;
+        --waiting;
+    }
+    state->closing = 1;
+    if (closing_count == closing_capacity) {
+        closing_capacity = closing_capacity ? closing_capacity * 2 : 16;
+        closing_fds = sa_checked_realloc(closing_fds, closing_capacity * sizeof(int64_t));
+    }
+    closing_fds[closing_count++] = fd;
+}
+
+// --- I/O operations ---
+// Called from compiled code for 'await accept(...)', 'await read(...)' and
+// 'await write(...)'. Each either finishes or returns SA_IO_PENDING.
+//
+// A failed 'listen' or 'connect' returns a negative descriptor; the
+// operations fail with EBADF on it rather than waiting for it, as they do
+// on a descriptor that is being closed.
+
+int64_t sa_io_accept(int64_t listener) {
+    if (listener < 0 || sa_io_closing(listener)) {
+        return -EBADF;
+    }
+    for (;;) {
+        int fd = accept4((int)listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd >= 0) {
+            return sa_io_register(fd);
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return SA_IO_PENDING;
+        }
+        // The connection was reset before it was accepted; take the next.
+        if (errno != EINTR && errno != ECONNABORTED) {
+            return -errno;
+        }
+    }
+}
+
+// Reads what has arrived into the descriptor's buffer, which '*data' is
+// set to. It stays valid until the next 'read' of a socket numbered 'fd',
+// even once 'fd' is closed.
+// Returns the number of bytes, 0 at the end of the stream, or -errno.
+int64_t sa_io_read(int64_t fd, const char** data) {
+    if (fd < 0 || sa_io_closing(fd)) {
+        return -EBADF;
+    }
+    sa_io_state* state = sa_io_state_of(fd);
+    if (!state->buffer) {
+        state->buffer = sa_checked_realloc(NULL, SA_IO_BUFFER_SIZE);
+    }
+    for (;;) {
+        ssize_t n = read((int)fd, state->buffer, SA_IO_BUFFER_SIZE);
+        if (n >= 0) {
+            *data = state->buffer;
+            return n;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return SA_IO_PENDING;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+// Writes all of 'data', across as many calls as it takes: how much is
+// already written is kept with the descriptor, so only one 'write' per
+// descriptor may be in progress. Returns 'length' or -errno.
+int64_t sa_io_write(int64_t fd, const char* data, int64_t length) {
+    if (fd < 0 || sa_io_closing(fd)) {
+        return -EBADF;
+    }
+    sa_io_state* state = sa_io_state_of(fd);
+    while (state->written < length) {
+        ssize_t n = send((int)fd, data + state->written, (size_t)(length - state->written),
+                         MSG_NOSIGNAL);
+        if (n >= 0) {
+            state->written += n;
+        } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+            return SA_IO_PENDING;
+        } else if (errno != EINTR) {
+            state->written = 0;
+            return -errno;
+        }
+    }
+    state->written = 0;
+    return length;
+}
+
+// --- The loop ---
+
+// Runs ready coroutines until none is left, then sleeps in epoll_wait
+// until a waiting one can go on. Returns when nothing is ready or waiting.
+void sa_async_run(void) {
+    struct epoll_event events[256];
+    for (;;) {
+        while (ready_count > 0) {
+            void* handle = ready[ready_head];
+            ready_head = (ready_head + 1) % ready_capacity;
+            --ready_count;
+            sa_async_resume(handle);
+        }
+        // The coroutines 'close' woke up have all failed by now.
+        for (size_t i = 0; i < closing_count; ++i) {
+            sa_io_close_now(closing_fds[i]);
+        }
+        closing_count = 0;
+        if (waiting == 0) {
+            return;
+        }
+
+        int n = epoll_wait(epoll_fd, events, (int)(sizeof(events) / sizeof(events[0])), -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("sa runtime: epoll_wait");
+            abort();
+        }
+        for (int i = 0; i < n; ++i) {
+            sa_io_state* state = sa_io_state_of(events[i].data.fd);
+            uint32_t flags = events[i].events;
+            // An error or hang-up wakes both sides; their retry reports it.
+            if ((flags & (EPOLLIN | EPOLLRDHUP | EPOLLERR | EPOLLHUP)) && state->reader) {
+                sa_async_ready(state->reader);
+                state->reader = NULL;
+                --waiting;
+            }
+            if ((flags & (EPOLLOUT | EPOLLERR | EPOLLHUP)) && state->writer) {
+                sa_async_ready(state->writer);
+                state->writer = NULL;
+                --waiting;
+            }
+        }
+    }
+}
@@ -0,0 +1,263 @@
+// minimal.c
+//
+// The freestanding runtime behind 'sac --runtime=minimal'. It does not sit
+// on top of the C library but replaces it: '_start' calls 'main' directly
+// and output goes straight to the 'write' system call. Linked statically
+// with nothing else, a program is a few KB and starts without a dynamic
+// loader or any libc initialization.
+//
+// Only what compiled code calls is provided. There is one thread, so a
+// spawned task runs to completion right away, which is all 'join' needs.
+// Linux on x86-64 and AArch64 only.
+//
+// Built with -ffreestanding and without stack protection (there is no TLS
+// to keep the canary in); see CMakeLists.txt.
+#include <stddef.h>
+#include <stdint.h>
+
+int main(void);
+
+// --- System calls ---
+
+#if defined(__x86_64__)
+#define SA_SYS_write 1
+#define SA_SYS_getpid 39
+#define SA_SYS_kill 62
+#define SA_SYS_exit_group 231
+
+static long sa_syscall3(long n, long a, long b, long c) {
+    long ret;
+    __asm__ volatile("syscall"
+                     : "=a"(ret)
+                     : "a"(n), "D"(a), "S"(b), "d"(c)
+                     : "rcx", "r11", "memory");
+    return ret;
+}
+#elif defined(__aarch64__)
+#define SA_SYS_write 64
+#define SA_SYS_getpid 172
+#define SA_SYS_kill 129
+#define SA_SYS_exit_group 94
+
+static long sa_syscall3(long n, long a, long b, long c) {
+    register long x8 __asm__("x8") = n;
+    register long x0 __asm__("x0") = a;
+    register long x1 __asm__("x1") = b;
+    register long x2 __asm__("x2") = c;
+    __asm__ volatile("svc 0" : "+r"(x0) : "r"(x8), "r"(x1), "r"(x2) : "memory");
+    return x0;
+}
+#else
+#error "The minimal runtime supports Linux on x86-64 and AArch64 only."
+#endif
+
+#define SA_EINTR 4
+#define SA_SIGABRT 6
+
+__attribute__((noreturn)) static void sa_exit(int status) {
+    for (;;) {
+        sa_syscall3(SA_SYS_exit_group, status, 0, 0);
+    }
+}
+
+// Writes all of 'data', retrying after a signal or a short write. Errors
+// are dropped: there is nowhere left to report them.
+static void sa_write_all(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        long written = sa_syscall3(SA_SYS_write, fd, (long)data, (long)length);
+        if (written == -SA_EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        length -= (size_t)written;
+    }
+}
+
+// --- Memory ---
+// The compiler may turn aggregate copies and zeroing into calls to these.
+
+void* memset(void* dest, int c, size_t n) {
+    unsigned char* d = dest;
+    while (n--) {
+        *d++ = (unsigned char)c;
+    }
+    return dest;
+}
+
+void* memcpy(void* restrict dest, const void* restrict src, size_t n) {
+    unsigned char* d = dest;
+    const unsigned char* s = src;
+    while (n--) {
+        *d++ = *s++;
+    }
+    return dest;
+}
+
+void* memmove(void* dest, const void* src, size_t n) {
+    unsigned char* d = dest;
+    const unsigned char* s = src;
+    if (d < s) {
+        while (n--) {
+            *d++ = *s++;
+        }
+    } else {
+        while (n--) {
+            d[n] = s[n];
+        }
+    }
+    return dest;
+}
+
+// --- Output ---
+// stdout is fully buffered, the way C buffers it for a file or a pipe, and
+// flushed when the program exits.
+
+static char sa_out[4096];
+static size_t sa_out_length;
+
+static void sa_flush(void) {
+    sa_write_all(1, sa_out, sa_out_length);
+    sa_out_length = 0;
+}
+
+static void sa_out_append(const char* data, size_t length) {
+    if (length > sizeof(sa_out) - sa_out_length) {
+        sa_flush();
+        if (length > sizeof(sa_out)) {
+            sa_write_all(1, data, length);
+            return;
+        }
+    }
+    memcpy(sa_out + sa_out_length, data, length);
+    sa_out_length += length;
+}
+
+void print(const char* message, int64_t length) {
+    sa_out_append(message, (size_t)length);
+    sa_out_append("\n", 1);
+}
+
+// Appends the decimal digits of 'value' at 'p' and returns the new end.
+static char* sa_format_int(char* p, int64_t value) {
+    uint64_t magnitude = (uint64_t)value;
+    if (value < 0) {
+        *p++ = '-';
+        magnitude = 0 - magnitude;
+    }
+    char digits[20];
+    int count = 0;
+    do {
+        digits[count++] = (char)('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+    while (count) {
+        *p++ = digits[--count];
+    }
+    return p;
+}
+
+static char* sa_format_str(char* p, const char* s) {
+    while (*s) {
+        *p++ = *s++;
+    }
+    return p;
+}
+
+// Writes the 'length' bytes at 'message' to stderr and aborts.
+__attribute__((noreturn)) static void sa_fail(const char* message, size_t length) {
+    sa_flush();
+    sa_write_all(2, message, length);
+    sa_syscall3(SA_SYS_kill, sa_syscall3(SA_SYS_getpid, 0, 0, 0), SA_SIGABRT, 0);
+    sa_exit(134); // SIGABRT is blocked; exit the way a shell reports it.
+}
+
+void sa_bounds_fail(int64_t index, int64_t length) {
+    char message[96];
+    char* p = sa_format_str(message, "sa: index ");
+    p = sa_format_int(p, index);
+    p = sa_format_str(p, " out of bounds for length ");
+    p = sa_format_int(p, length);
+    *p++ = '\n';
+    sa_fail(message, (size_t)(p - message));
+}
+
+void sa_div_fail(int64_t dividend, int64_t divisor) {
+    char message[96];
+    char* p = sa_format_str(message, "sa: division of ");
+    p = sa_format_int(p, dividend);
+    if (divisor == 0) {
+        p = sa_format_str(p, " by zero");
+    } else {
+        p = sa_format_str(p, " by ");
+        p = sa_format_int(p, divisor);
+        p = sa_format_str(p, " overflows");
+    }
+    *p++ = '\n';
+    sa_fail(message, (size_t)(p - message));
+}
+
+// --- Tasks and regions ---
+
+void sa_spawn(void* group, void (*fn)(void*), const void* env, size_t env_size) {
+    (void)group;
+    (void)env_size;
+    fn((void*)env);
+}
+
+void sa_join(void* group) {
+    (void)group;
+}
+
+// Tasks run right away, without a record to allocate, and nothing else
+// allocates from regions, so there is nothing to release.
+void sa_region_enter(void* region) {
+    (void)region;
+}
+
+void sa_region_exit(void* region) {
+    (void)region;
+}
+
+// --- Start-up ---
+
+// A static executable resolves its ifuncs ('@target_clones') itself. The
+// linker brackets the IRELATIVE relocations that do so with these symbols.
+typedef struct sa_rela {
+    uint64_t offset;
+    uint64_t info;
+    int64_t addend;
+} sa_rela;
+extern const sa_rela __rela_iplt_start[] __attribute__((weak, visibility("hidden")));
+extern const sa_rela __rela_iplt_end[] __attribute__((weak, visibility("hidden")));
+
+__attribute__((noreturn, used, visibility("hidden"))) void sa_start(void) {
+    for (const sa_rela* r = __rela_iplt_start; r < __rela_iplt_end; ++r) {
+        uint64_t (*resolver)(void) = (uint64_t(*)(void))(uintptr_t)r->addend;
+        *(uint64_t*)(uintptr_t)r->offset = resolver();
+    }
+    int status = main();
+    sa_flush();
+    sa_exit(status);
+}
+
+// The kernel enters with the stack pointer at 'argc'. 'sa' programs take no
+// arguments, so '_start' only clears the frame pointer (and link register)
+// that end stack traces and aligns the stack for C.
+__asm__(".text\n"
+        ".global _start\n"
+        ".type _start, %function\n"
+        "_start:\n"
+#if defined(__x86_64__)
+        "    xor %ebp, %ebp\n"
+        "    and $-16, %rsp\n"
+        "    call sa_start\n"
+        "    hlt\n"
+#else
+        "    mov x29, #0\n"
+        "    mov x30, #0\n"
+        "    bl sa_start\n"
+#endif
+);
@@ -1,7 +1,32 @@
 // runtime.c
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 // This is the implementation of the 'print' function that your compiler can call.
-void print(const char* message) {
-    printf("%s\n", message);
-}
\ No newline at end of file
+// An 'sa' str arrives as its pointer and length; it is not NUL-terminated.
+void print(const char* message, int64_t length) {
+    fwrite(message, 1, (size_t)length, stdout);
+    putchar('\n');
+}
+
+// Called by a failed bounds check: 'index' is outside [0, length). It does
+// not return, so the compiler can assume every index after a check is in
+// range.
+void sa_bounds_fail(int64_t index, int64_t length) {
+    fflush(stdout);
+    fprintf(stderr, "sa: index %lld out of bounds for length %lld\n", (long long)index, (long long)length);
+    abort();
+}
+
+// Called by a failed division check: 'divisor' is 0, or it is -1 and
+// 'dividend' the smallest i64, whose negation does not fit.
+void sa_div_fail(int64_t dividend, int64_t divisor) {
+    fflush(stdout);
+    if (divisor == 0) {
+        fprintf(stderr, "sa: division of %lld by zero\n", (long long)dividend);
+    } else {
+        fprintf(stderr, "sa: division of %lld by %lld overflows\n", (long long)dividend, (long long)divisor);
+    }
+    abort();
+}
@@ -0,0 +1,348 @@
+// scheduler.c
+//
+// The task scheduler behind 'spawn' and 'join'.
+//
+// Every worker thread owns a Chase-Lev work-stealing deque: it pushes and
+// pops spawned tasks at the bottom of its own deque, and when that runs dry
+// it steals from the top of a random victim's deque. The thread that spawns
+// first becomes worker 0, so 'main' takes part in the work while it joins.
+// Idle workers spin briefly and then sleep on a condition variable until
+// new work is spawned.
+//
+// The deque follows "Correct and Efficient Work-Stealing for Weak Memory
+// Models" (Le, Pop, Cohen, Zappa Nardelli; PPoPP 2013).
+#include "alloc.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// The compiler allocates one group per function that spawns, on the stack,
+// as a single zero-initialized 64-bit counter. 'join' waits for it to drop
+// back to zero.
+typedef struct sa_task_group {
+    _Atomic long pending;
+} sa_task_group;
+
+typedef struct sa_task {
+    void (*fn)(void*);
+    sa_task_group* group;
+    // Set if the task was allocated from the spawner's region, which
+    // releases it along with everything else.
+    int in_region;
+    // The spawn site's arguments, copied so that they outlive its frame.
+    _Alignas(16) unsigned char env[];
+} sa_task;
+
+// --- Chase-Lev deque ---
+
+typedef struct sa_deque_array {
+    int64_t capacity; // Always a power of two.
+    // Arrays replaced by a resize are kept alive: a thief may still be
+    // reading from them.
+    struct sa_deque_array* previous;
+    _Atomic(sa_task*) slots[];
+} sa_deque_array;
+
+typedef struct sa_deque {
+    _Atomic int64_t top;
+    _Atomic int64_t bottom;
+    _Atomic(sa_deque_array*) array;
+} sa_deque;
+
+static sa_deque_array* deque_array_new(int64_t capacity, sa_deque_array* previous) {
+    sa_deque_array* a = malloc(sizeof(sa_deque_array) + (size_t)capacity * sizeof(_Atomic(sa_task*)));
+    if (!a) {
+        fputs("sa runtime: out of memory\n", stderr);
+        abort();
+    }
+    a->capacity = capacity;
+    a->previous = previous;
+    return a;
+}
+
+static void deque_init(sa_deque* d) {
+    atomic_init(&d->top, 0);
+    atomic_init(&d->bottom, 0);
+    atomic_init(&d->array, deque_array_new(256, NULL));
+}
+
+// Owner only.
+static void deque_push(sa_deque* d, sa_task* task) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    sa_deque_array* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+
+    if (b - t > a->capacity - 1) {
+        sa_deque_array* grown = deque_array_new(a->capacity * 2, a);
+        for (int64_t i = t; i < b; ++i) {
+            sa_task* x = atomic_load_explicit(&a->slots[i & (a->capacity - 1)], memory_order_relaxed);
+            atomic_store_explicit(&grown->slots[i & (grown->capacity - 1)], x, memory_order_relaxed);
+        }
+        atomic_store_explicit(&d->array, grown, memory_order_release);
+        a = grown;
+    }
+
+    atomic_store_explicit(&a->slots[b & (a->capacity - 1)], task, memory_order_relaxed);
+    // Publishes the task (and its contents) to thieves that acquire 'bottom'.
+    atomic_store_explicit(&d->bottom, b + 1, memory_order_release);
+}
+
+// Owner only. Returns the most recently pushed task, or NULL.
+static sa_task* deque_pop(sa_deque* d) {
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_relaxed) - 1;
+    sa_deque_array* a = atomic_load_explicit(&d->array, memory_order_relaxed);
+    atomic_store_explicit(&d->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t t = atomic_load_explicit(&d->top, memory_order_relaxed);
+
+    if (t > b) {
+        // Empty.
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    sa_task* x = atomic_load_explicit(&a->slots[b & (a->capacity - 1)], memory_order_relaxed);
+    if (t == b) {
+        // Last element: race the thieves for it.
+        if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                     memory_order_seq_cst, memory_order_relaxed)) {
+            x = NULL;
+        }
+        atomic_store_explicit(&d->bottom, b + 1, memory_order_relaxed);
+    }
+    return x;
+}
+
+// Any thread. Returns the oldest task, or NULL if the deque is empty or
+// another thread won the race for it.
+static sa_task* deque_steal(sa_deque* d) {
+    int64_t t = atomic_load_explicit(&d->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    int64_t b = atomic_load_explicit(&d->bottom, memory_order_acquire);
+    if (t >= b) {
+        return NULL;
+    }
+
+    sa_deque_array* a = atomic_load_explicit(&d->array, memory_order_acquire);
+    sa_task* x = atomic_load_explicit(&a->slots[t & (a->capacity - 1)], memory_order_relaxed);
+    if (!atomic_compare_exchange_strong_explicit(&d->top, &t, t + 1,
+                                                 memory_order_seq_cst, memory_order_relaxed)) {
+        return NULL;
+    }
+    return x;
+}
+
+// --- Workers ---
+
+typedef struct sa_worker {
+    sa_deque deque;
+    uint64_t rng; // xorshift state for picking steal victims.
+} sa_worker;
+
+static sa_worker* workers;
+static unsigned num_workers;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+static _Thread_local sa_worker* current_worker;
+
+// Tasks spawned from threads the scheduler did not create (other than the
+// one that started it) cannot use a deque; they are queued here instead.
+static pthread_mutex_t inject_lock = PTHREAD_MUTEX_INITIALIZER;
+static sa_task** inject_queue;
+static size_t inject_count, inject_capacity;
+
+// The number of tasks pushed but not yet taken, across all queues. Idle
+// workers only go to sleep when it is zero.
+static _Atomic long queued_tasks;
+static _Atomic int sleeping_workers;
+static pthread_mutex_t sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sleep_cond = PTHREAD_COND_INITIALIZER;
+
+// How many rounds of failed steal attempts a worker makes before sleeping.
+#define SA_IDLE_SPINS 64
+
+static sa_task* inject_take(void) {
+    sa_task* task = NULL;
+    pthread_mutex_lock(&inject_lock);
+    if (inject_count > 0) {
+        task = inject_queue[--inject_count];
+    }
+    pthread_mutex_unlock(&inject_lock);
+    return task;
+}
+
+static uint64_t next_random(sa_worker* w) {
+    w->rng ^= w->rng << 13;
+    w->rng ^= w->rng >> 7;
+    w->rng ^= w->rng << 17;
+    return w->rng;
+}
+
+// Looks for a task to run: own deque first, then the other workers, then
+// the injection queue. Returns NULL if none was found in one pass.
+static sa_task* find_task(sa_worker* self) {
+    sa_task* task = self ? deque_pop(&self->deque) : NULL;
+
+    if (!task && num_workers > 1) {
+        unsigned start = self ? (unsigned)(next_random(self) % num_workers) : 0;
+        for (unsigned i = 0; i < num_workers && !task; ++i) {
+            sa_worker* victim = &workers[(start + i) % num_workers];
+            if (victim != self) {
+                task = deque_steal(&victim->deque);
+            }
+        }
+    }
+
+    if (!task && atomic_load_explicit(&queued_tasks, memory_order_relaxed) > 0) {
+        task = inject_take();
+    }
+
+    if (task) {
+        atomic_fetch_sub_explicit(&queued_tasks, 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static void run_task(sa_task* task) {
+    sa_task_group* group = task->group;
+    task->fn(task->env);
+    if (!task->in_region) {
+        free(task);
+    }
+    atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+static void wake_one_worker(void) {
+    if (atomic_load(&sleeping_workers) > 0) {
+        pthread_mutex_lock(&sleep_lock);
+        pthread_cond_signal(&sleep_cond);
+        pthread_mutex_unlock(&sleep_lock);
+    }
+}
+
+static void* worker_main(void* arg) {
+    sa_worker* self = arg;
+    current_worker = self;
+
+    for (;;) {
+        sa_task* task = NULL;
+        for (int spin = 0; spin < SA_IDLE_SPINS && !task; ++spin) {
+            task = find_task(self);
+            if (!task) {
+                sched_yield();
+            }
+        }
+        if (task) {
+            run_task(task);
+            continue;
+        }
+
+        // Nothing to do: sleep until a spawn signals. The sleeper count is
+        // published before re-checking for work, and spawners count their
+        // task before reading the sleeper count, so a wakeup cannot be lost.
+        pthread_mutex_lock(&sleep_lock);
+        atomic_fetch_add(&sleeping_workers, 1);
+        if (atomic_load(&queued_tasks) == 0) {
+            pthread_cond_wait(&sleep_cond, &sleep_lock);
+        }
+        atomic_fetch_sub(&sleeping_workers, 1);
+        pthread_mutex_unlock(&sleep_lock);
+    }
+    return NULL;
+}
+
+static void scheduler_init(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    const char* env = getenv("SA_NUM_WORKERS");
+    if (env && atol(env) > 0) {
+        n = atol(env);
+    }
+    num_workers = n > 0 ? (unsigned)n : 1;
+
+    workers = calloc(num_workers, sizeof(sa_worker));
+    if (!workers) {
+        fputs("sa runtime: out of memory\n", stderr);
+        abort();
+    }
+    for (unsigned i = 0; i < num_workers; ++i) {
+        deque_init(&workers[i].deque);
+        workers[i].rng = 0x9E3779B97F4A7C15ull * (i + 1);
+    }
+
+    // The initializing thread is worker 0; the rest get their own threads.
+    current_worker = &workers[0];
+    for (unsigned i = 1; i < num_workers; ++i) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, worker_main, &workers[i]) != 0) {
+            fputs("sa runtime: could not start worker thread\n", stderr);
+            abort();
+        }
+        pthread_detach(thread);
+    }
+}
+
+// --- Compiler interface ---
+
+// Queues fn(env) to run on some worker. 'env' holds the spawn site's
+// arguments and is copied, so the caller may reuse it immediately.
+void sa_spawn(sa_task_group* group, void (*fn)(void*), const void* env, size_t env_size) {
+    pthread_once(&init_once, scheduler_init);
+
+    // Inside a 'region' block the task comes from the region, which
+    // outlives it: the block joins every task before releasing its memory.
+    // Elsewhere it is not from the size-class pools: a task is usually
+    // freed by the worker that stole it, and the pools would keep the
+    // memory on that worker's free list while the spawner allocates more.
+    size_t size = sizeof(sa_task) + env_size;
+    sa_region* region = sa_current_region();
+    sa_task* task = region ? sa_region_alloc(region, size, 16) : malloc(size);
+    if (!task) {
+        fputs("sa runtime: out of memory\n", stderr);
+        abort();
+    }
+    task->fn = fn;
+    task->group = group;
+    task->in_region = region != NULL;
+    if (env_size > 0) {
+        memcpy(task->env, env, env_size);
+    }
+
+    atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+    atomic_fetch_add(&queued_tasks, 1);
+
+    if (current_worker) {
+        deque_push(&current_worker->deque, task);
+    } else {
+        pthread_mutex_lock(&inject_lock);
+        if (inject_count == inject_capacity) {
+            inject_capacity = inject_capacity ? inject_capacity * 2 : 64;
+            inject_queue = realloc(inject_queue, inject_capacity * sizeof(sa_task*));
+            if (!inject_queue) {
+                fputs("sa runtime: out of memory\n", stderr);
+                abort();
+            }
+        }
+        inject_queue[inject_count++] = task;
+        pthread_mutex_unlock(&inject_lock);
+    }
+
+    wake_one_worker();
+}
+
+// Waits until every task spawned into 'group' has finished. The waiting
+// thread runs queued tasks itself in the meantime instead of blocking.
+void sa_join(sa_task_group* group) {
+    while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0) {
+        sa_task* task = find_task(current_worker);
+        if (task) {
+            run_task(task);
+        } else {
+            sched_yield();
+        }
+    }
+}
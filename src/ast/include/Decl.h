@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include "ast/include/Type.h"
 #include "core/include/Token.h"
 #include <memory>
 #include <string_view>
@@ -17,6 +18,7 @@ namespace sa {
 class Stmt;
 class Expr;
 class Visitor;
+class ModuleFile;
 
 // The base class for all AST nodes.
 class ASTNode {
@@ -37,32 +39,197 @@ public:
 };
 
 // Represents a variable declaration: 'let message = "Hello, sa!";'
+// The type may be written out, 'let n: i64 = 0;', and must be if there is
+// no initializer: 'let points: [Point; 64];' starts out zeroed.
 class VarDecl : public Decl {
     // We use unique_ptr for automatic memory management of the AST.
     // The VarDecl 'owns' its initializer expression.
     std::unique_ptr<Expr> Initializer;
 
+    // Void if the type is inferred from the initializer.
+    Type DeclaredType;
+
 public:
-    VarDecl(const Token& name, std::unique_ptr<Expr> initializer)
-        : Decl(name), Initializer(std::move(initializer)) {}
+    VarDecl(const Token& name, std::unique_ptr<Expr> initializer, Type declaredType = Type())
+        : Decl(name), Initializer(std::move(initializer)), DeclaredType(std::move(declaredType)) {}
     
     void accept(Visitor& visitor) override;
     
     Expr* getInitializer() const { return Initializer.get(); }
+    const Type& getDeclaredType() const { return DeclaredType; }
+};
+
+// Annotations that can precede a function: '@inline fn ...'.
+// They are stored as a bit set on the FunctionDecl.
+enum FunctionAttr : unsigned {
+    FA_None     = 0,
+    FA_Inline   = 1 << 0, // Always inline into callers.
+    FA_NoInline = 1 << 1, // Never inline.
+    FA_Hot      = 1 << 2, // Frequently executed; grouped with other hot code.
+    FA_Cold     = 1 << 3, // Rarely executed; kept out of the hot text.
+    FA_Pure     = 1 << 4, // No side effects; result depends only on arguments.
+};
+
+// A function parameter: the 'name: str' in 'fn greet(name: str) -> void'.
+struct Param {
+    Token Name;
+    Type Ty;
 };
 
 // Represents a function declaration: 'fn main() -> void { ... }'
 class FunctionDecl : public Decl {
+    // The 'T' in 'fn max<T>(a: T, b: T) -> T'. A function with type
+    // parameters is generic: it is only compiled once per distinct list of
+    // type arguments it is called with.
+    std::vector<Token> TypeParams;
+
+    std::vector<Param> Params;
+    Type ReturnType;
+
     // The function 'owns' all the statements in its body.
     std::vector<std::unique_ptr<Stmt>> Body;
 
+    // Set for 'export fn ...'; only exported functions are written to the
+    // module interface file.
+    bool Exported = false;
+
+    // Set for 'async fn ...', which may 'await' and runs as a coroutine.
+    bool Async = false;
+
+    // Set for functions materialized from an imported module interface.
+    // Their definition lives in another object file; if HasBody is set the
+    // body was serialized so that it can still be inlined here.
+    bool Imported = false;
+    bool HasBody = true;
+
+    // A bit set of FunctionAttr values.
+    unsigned Attrs = FA_None;
+
+    // The instruction sets named by '@target_clones("avx2", "default")'.
+    // The function is compiled once per entry and the best clone for the
+    // running CPU is picked when the program is loaded.
+    std::vector<std::string_view> TargetClones;
+
+    // Set while the body has only been skimmed rather than parsed: the
+    // source text of the body (braces included), the line it starts on and
+    // every name that appears called in it.
+    std::string_view SkimmedBody;
+    unsigned int SkimmedBodyLine = 0;
+    std::vector<std::string_view> SkimmedCallees;
+
 public:
-    FunctionDecl(const Token& name, std::vector<std::unique_ptr<Stmt>> body)
-        : Decl(name), Body(std::move(body)) {}
+    FunctionDecl(const Token& name, std::vector<Param> params, std::vector<std::unique_ptr<Stmt>> body)
+        : Decl(name), Params(std::move(params)), Body(std::move(body)) {}
     
     void accept(Visitor& visitor) override;
     
+    const std::vector<Param>& getParams() const { return Params; }
+
+    const Type& getReturnType() const { return ReturnType; }
+    void setReturnType(Type type) { ReturnType = type; }
+
+    const std::vector<Token>& getTypeParams() const { return TypeParams; }
+    void setTypeParams(std::vector<Token> typeParams) { TypeParams = std::move(typeParams); }
+    bool isGeneric() const { return !TypeParams.empty(); }
+
     const std::vector<std::unique_ptr<Stmt>>& getBody() const { return Body; }
+
+    bool isSkimmed() const { return !SkimmedBody.empty(); }
+    std::string_view getSkimmedBody() const { return SkimmedBody; }
+    unsigned int getSkimmedBodyLine() const { return SkimmedBodyLine; }
+    const std::vector<std::string_view>& getSkimmedCallees() const { return SkimmedCallees; }
+    void setSkimmedBody(std::string_view text, unsigned int line, std::vector<std::string_view> callees) {
+        SkimmedBody = text;
+        SkimmedBodyLine = line;
+        SkimmedCallees = std::move(callees);
+    }
+
+    // Replaces a skimmed body by the parsed one.
+    void setBody(std::vector<std::unique_ptr<Stmt>> body) {
+        Body = std::move(body);
+        SkimmedBody = {};
+        SkimmedCallees.clear();
+    }
+
+    // Frees the body once code has been generated for it. The signature
+    // stays for the calls that follow.
+    void releaseBody() { std::vector<std::unique_ptr<Stmt>>().swap(Body); }
+
+    bool isExported() const { return Exported; }
+    void setExported(bool exported) { Exported = exported; }
+
+    bool isAsync() const { return Async; }
+    void setAsync(bool async) { Async = async; }
+
+    unsigned getAttrs() const { return Attrs; }
+    bool hasAttr(FunctionAttr attr) const { return (Attrs & attr) != 0; }
+    void setAttrs(unsigned attrs) { Attrs = attrs; }
+
+    const std::vector<std::string_view>& getTargetClones() const { return TargetClones; }
+    void setTargetClones(std::vector<std::string_view> clones) { TargetClones = std::move(clones); }
+
+    bool isImported() const { return Imported; }
+    bool hasBody() const { return HasBody; }
+    void markImported(bool hasBody) {
+        Imported = true;
+        HasBody = hasBody;
+    }
+};
+
+// Annotations that can precede a struct: '@packed struct Header { ... }'.
+enum StructAttr : unsigned {
+    SA_None   = 0,
+    SA_Packed = 1 << 0, // No padding between or after the fields.
+    SA_SoA    = 1 << 1, // Arrays of it store each field in an array of its own.
+};
+
+// A struct field: the 'x: i64' in 'struct Point { x: i64, y: i64 }'.
+struct Field {
+    Token Name;
+    Type Ty;
+};
+
+// Represents a struct declaration: 'struct Point { x: i64, y: i64 }'.
+// Unless it is '@packed', the fields may be laid out in a different order
+// than they are declared in, to leave as little padding as possible.
+class StructDecl : public Decl {
+    std::vector<Field> Fields;
+
+    // A bit set of StructAttr values.
+    unsigned Attrs = SA_None;
+
+    // The alignment '@align(N)' asks for, in bytes, or 0.
+    uint64_t Align = 0;
+
+public:
+    StructDecl(const Token& name, std::vector<Field> fields)
+        : Decl(name), Fields(std::move(fields)) {}
+
+    void accept(Visitor& visitor) override;
+
+    const std::vector<Field>& getFields() const { return Fields; }
+
+    unsigned getAttrs() const { return Attrs; }
+    bool hasAttr(StructAttr attr) const { return (Attrs & attr) != 0; }
+    void setAttrs(unsigned attrs) { Attrs = attrs; }
+
+    uint64_t getAlign() const { return Align; }
+    void setAlign(uint64_t align) { Align = align; }
+};
+
+// Represents a module import: 'import greet;'
+// The parser only records the module name. The driver resolves it to a
+// precompiled module interface before code generation.
+class ImportDecl : public Decl {
+    std::shared_ptr<ModuleFile> Module;
+
+public:
+    ImportDecl(const Token& name) : Decl(name) {}
+
+    void accept(Visitor& visitor) override;
+
+    ModuleFile* getModule() const { return Module.get(); }
+    void setModule(std::shared_ptr<ModuleFile> module) { Module = std::move(module); }
 };
 
 } // namespace sa
\ No newline at end of file
@@ -9,6 +9,7 @@
 
 #include "ast/include/Stmt.h" // An Expr is a kind of Stmt.
 #include "core/include/Token.h"
+#include <cstdint>
 #include <memory>
 #include <string_view>
 #include <vector>
@@ -34,6 +35,53 @@ public:
         // The lexeme includes the quotes, so we return a substring without them.
         return StrToken.lexeme.substr(1, StrToken.lexeme.length() - 2);
     }
+
+    // Returns the literal as spelled in the source, including the quotes.
+    std::string_view getLexeme() const { return StrToken.lexeme; }
+};
+
+// Represents an integer literal, e.g., 42. Its type is 'i64'.
+class IntegerLiteralExpr : public Expr {
+    Token IntToken;
+
+public:
+    IntegerLiteralExpr(const Token& token) : IntToken(token) {}
+
+    void accept(Visitor& visitor) override;
+
+    // The digits as written in the source.
+    std::string_view getLexeme() const { return IntToken.lexeme; }
+};
+
+// Represents 'true' or 'false'.
+class BoolLiteralExpr : public Expr {
+    Token BoolToken;
+
+public:
+    BoolLiteralExpr(const Token& token) : BoolToken(token) {}
+
+    void accept(Visitor& visitor) override;
+
+    bool getValue() const { return BoolToken.kind == tok::kw_true; }
+};
+
+// Represents a binary operation, e.g., a + b or a < b.
+// Arithmetic takes two 'i64' values; comparisons produce a 'bool'.
+class BinaryExpr : public Expr {
+    Token Op;
+    std::unique_ptr<Expr> LHS;
+    std::unique_ptr<Expr> RHS;
+
+public:
+    BinaryExpr(const Token& op, std::unique_ptr<Expr> lhs, std::unique_ptr<Expr> rhs)
+        : Op(op), LHS(std::move(lhs)), RHS(std::move(rhs)) {}
+
+    void accept(Visitor& visitor) override;
+
+    tok::TokenKind getOp() const { return Op.kind; }
+    std::string_view getOpSpelling() const { return Op.lexeme; }
+    Expr* getLHS() const { return LHS.get(); }
+    Expr* getRHS() const { return RHS.get(); }
 };
 
 // Represents the use of a variable in an expression.
@@ -49,6 +97,81 @@ public:
     std::string_view getName() const { return Name.lexeme; }
 };
 
+// Represents creating a struct value: 'Point { x: 1, y: 2 }'. Every field
+// must be given exactly once, in any order.
+class StructLiteralExpr : public Expr {
+    Token Name;
+    std::vector<std::pair<Token, std::unique_ptr<Expr>>> Fields;
+
+public:
+    StructLiteralExpr(const Token& name, std::vector<std::pair<Token, std::unique_ptr<Expr>>> fields)
+        : Name(name), Fields(std::move(fields)) {}
+
+    void accept(Visitor& visitor) override;
+
+    std::string_view getName() const { return Name.lexeme; }
+    const std::vector<std::pair<Token, std::unique_ptr<Expr>>>& getFields() const { return Fields; }
+};
+
+// Represents reading a field of a struct: 'p.x'.
+class FieldExpr : public Expr {
+    std::unique_ptr<Expr> Base;
+    Token Name;
+
+public:
+    FieldExpr(std::unique_ptr<Expr> base, const Token& name)
+        : Base(std::move(base)), Name(name) {}
+
+    void accept(Visitor& visitor) override;
+
+    Expr* getBase() const { return Base.get(); }
+    std::string_view getName() const { return Name.lexeme; }
+};
+
+// Whether an array access needs its index checked against the length.
+enum class BoundsCheck : uint8_t {
+    Needed,  // Checked when the access is executed.
+    Proven,  // The index is always in range; no check.
+    Hoisted, // Covered by a check of the enclosing loop's whole range.
+};
+
+// Represents reading an element of an array or slice: 'points[i]'.
+class IndexExpr : public Expr {
+    std::unique_ptr<Expr> Base;
+    std::unique_ptr<Expr> Index;
+    BoundsCheck Check = BoundsCheck::Needed;
+
+public:
+    IndexExpr(std::unique_ptr<Expr> base, std::unique_ptr<Expr> index)
+        : Base(std::move(base)), Index(std::move(index)) {}
+
+    void accept(Visitor& visitor) override;
+
+    Expr* getBase() const { return Base.get(); }
+    Expr* getIndex() const { return Index.get(); }
+
+    BoundsCheck getBoundsCheck() const { return Check; }
+    void setBoundsCheck(BoundsCheck check) { Check = check; }
+};
+
+// Represents a slice of some elements of an array, slice or string:
+// 'points[lo..hi]', from 'lo' up to, but not including, 'hi'.
+class SliceExpr : public Expr {
+    std::unique_ptr<Expr> Base;
+    std::unique_ptr<Expr> Lo;
+    std::unique_ptr<Expr> Hi;
+
+public:
+    SliceExpr(std::unique_ptr<Expr> base, std::unique_ptr<Expr> lo, std::unique_ptr<Expr> hi)
+        : Base(std::move(base)), Lo(std::move(lo)), Hi(std::move(hi)) {}
+
+    void accept(Visitor& visitor) override;
+
+    Expr* getBase() const { return Base.get(); }
+    Expr* getLo() const { return Lo.get(); }
+    Expr* getHi() const { return Hi.get(); }
+};
+
 // Represents a function call expression, e.g., print(message).
 class CallExpr : public Expr {
     Token Callee;
@@ -64,4 +187,18 @@ public:
     const std::vector<std::unique_ptr<Expr>>& getArgs() const { return Args; }
 };
 
+// Represents 'await accept(listener)': calls an async function and
+// suspends the calling one, which must be async too, until the call has
+// produced its value.
+class AwaitExpr : public Expr {
+    std::unique_ptr<CallExpr> Call;
+
+public:
+    AwaitExpr(std::unique_ptr<CallExpr> call) : Call(std::move(call)) {}
+
+    void accept(Visitor& visitor) override;
+
+    CallExpr* getCall() const { return Call.get(); }
+};
+
 } // namespace sa
\ No newline at end of file
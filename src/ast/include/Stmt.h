@@ -8,12 +8,14 @@
 
 #include "ast/include/Decl.h" // For ASTNode
 #include <memory>
+#include <vector>
 
 namespace sa {
 
 // Forward-declarations to avoid circular include dependencies.
 class Decl;
 class Expr;
+class CallExpr;
 class Visitor;
 
 // The base class for all statement nodes in the AST.
@@ -54,4 +56,140 @@ public:
     Expr* getExpr() const { return E.get(); }
 };
 
+// Represents returning from the enclosing function: 'return value;', or
+// 'return;' in a function returning void.
+class ReturnStmt : public Stmt {
+    std::unique_ptr<Expr> Value;
+
+public:
+    ReturnStmt(std::unique_ptr<Expr> value) : Value(std::move(value)) {}
+
+    void accept(Visitor& visitor) override;
+
+    Expr* getValue() const { return Value.get(); }
+};
+
+// Represents storing a value into a variable, a field or an array
+// element: 'p.x = 3;'.
+class AssignStmt : public Stmt {
+    std::unique_ptr<Expr> Target;
+    std::unique_ptr<Expr> Value;
+
+public:
+    AssignStmt(std::unique_ptr<Expr> target, std::unique_ptr<Expr> value)
+        : Target(std::move(target)), Value(std::move(value)) {}
+
+    void accept(Visitor& visitor) override;
+
+    Expr* getTarget() const { return Target.get(); }
+    Expr* getValue() const { return Value.get(); }
+};
+
+// Represents 'if cond { ... } else { ... }'. The 'else' part is optional.
+// Names declared in either block end with it.
+class IfStmt : public Stmt {
+    std::unique_ptr<Expr> Cond;
+    std::vector<std::unique_ptr<Stmt>> Then;
+    std::vector<std::unique_ptr<Stmt>> Else;
+
+public:
+    IfStmt(std::unique_ptr<Expr> cond, std::vector<std::unique_ptr<Stmt>> thenBody,
+           std::vector<std::unique_ptr<Stmt>> elseBody)
+        : Cond(std::move(cond)), Then(std::move(thenBody)), Else(std::move(elseBody)) {}
+
+    void accept(Visitor& visitor) override;
+
+    Expr* getCond() const { return Cond.get(); }
+    const std::vector<std::unique_ptr<Stmt>>& getThen() const { return Then; }
+    const std::vector<std::unique_ptr<Stmt>>& getElse() const { return Else; }
+};
+
+// Represents 'while cond { ... }'.
+class WhileStmt : public Stmt {
+    std::unique_ptr<Expr> Cond;
+    std::vector<std::unique_ptr<Stmt>> Body;
+
+public:
+    WhileStmt(std::unique_ptr<Expr> cond, std::vector<std::unique_ptr<Stmt>> body)
+        : Cond(std::move(cond)), Body(std::move(body)) {}
+
+    void accept(Visitor& visitor) override;
+
+    Expr* getCond() const { return Cond.get(); }
+    const std::vector<std::unique_ptr<Stmt>>& getBody() const { return Body; }
+};
+
+// Represents 'for i in lo..hi { ... }': runs the body for each 'i64' from
+// 'lo' up to, but not including, 'hi'. Both bounds are evaluated once,
+// before the first iteration.
+class ForStmt : public Stmt {
+    Token Var;
+    std::unique_ptr<Expr> Lo;
+    std::unique_ptr<Expr> Hi;
+    std::vector<std::unique_ptr<Stmt>> Body;
+
+    // Arrays and slices the body indexes with the loop variable on every
+    // iteration. Instead of checking each access, the whole range is
+    // checked against their lengths once, before the loop; see
+    // eliminateBoundsChecks.
+    std::vector<std::string_view> HoistedChecks;
+
+public:
+    ForStmt(const Token& var, std::unique_ptr<Expr> lo, std::unique_ptr<Expr> hi,
+            std::vector<std::unique_ptr<Stmt>> body)
+        : Var(var), Lo(std::move(lo)), Hi(std::move(hi)), Body(std::move(body)) {}
+
+    void accept(Visitor& visitor) override;
+
+    std::string_view getVar() const { return Var.lexeme; }
+    Expr* getLo() const { return Lo.get(); }
+    Expr* getHi() const { return Hi.get(); }
+    const std::vector<std::unique_ptr<Stmt>>& getBody() const { return Body; }
+
+    const std::vector<std::string_view>& getHoistedChecks() const { return HoistedChecks; }
+    void addHoistedCheck(std::string_view name) {
+        for (std::string_view check : HoistedChecks) {
+            if (check == name) {
+                return;
+            }
+        }
+        HoistedChecks.push_back(name);
+    }
+};
+
+// Represents running a call as a parallel task: 'spawn work(item);'
+// The arguments are evaluated immediately; the call itself may run on any
+// worker thread, at any point before the next 'join' in the same function.
+class SpawnStmt : public Stmt {
+    std::unique_ptr<CallExpr> Call;
+
+public:
+    SpawnStmt(std::unique_ptr<CallExpr> call) : Call(std::move(call)) {}
+
+    void accept(Visitor& visitor) override;
+
+    CallExpr* getCall() const { return Call.get(); }
+};
+
+// Represents waiting for all tasks spawned so far by the enclosing
+// function: 'join;'. A function implicitly joins before it returns.
+class JoinStmt : public Stmt {
+public:
+    void accept(Visitor& visitor) override;
+};
+
+// Represents a block whose allocations all come from one arena:
+// 'region { ... }'. Everything allocated inside is released at once when
+// the block ends, so nothing declared inside may be used after it.
+class RegionStmt : public Stmt {
+    std::vector<std::unique_ptr<Stmt>> Body;
+
+public:
+    RegionStmt(std::vector<std::unique_ptr<Stmt>> body) : Body(std::move(body)) {}
+
+    void accept(Visitor& visitor) override;
+
+    const std::vector<std::unique_ptr<Stmt>>& getBody() const { return Body; }
+};
+
 } // namespace sa
\ No newline at end of file
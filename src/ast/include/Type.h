@@ -0,0 +1,133 @@
+//===--- Type.h - The 'sa' Language Types -----------------------*- C++ -*-===//
+//
+// This file defines Type, the types values and parameters can have in the
+// 'sa' language.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace sa {
+
+enum class TypeKind : uint8_t {
+    Void,
+    // A string slice: a pointer to the first byte and a length. Strings are
+    // not NUL-terminated, so their length is always known without a scan
+    // and a slice of one shares its bytes instead of copying them.
+    Str,
+    I64,
+    Bool,
+    // A type parameter of a generic function, like the 'T' in
+    // 'fn max<T>(a: T, b: T) -> T'. It stands for the type argument of
+    // whichever instantiation is being generated.
+    Param,
+    // A value of a struct declared with 'struct Name { ... }'.
+    Struct,
+    // A fixed number of values of one type stored one after the other:
+    // '[i64; 16]'.
+    Array,
+    // A view of some of the elements of an array: a pointer to the first
+    // and their number. '[]i64'.
+    Slice,
+};
+
+class Type {
+    TypeKind Kind = TypeKind::Void;
+    std::string_view Name; // Only for TypeKind::Param and TypeKind::Struct.
+
+    // Only for TypeKind::Array and TypeKind::Slice.
+    std::shared_ptr<const Type> Element;
+    uint64_t Length = 0;
+
+public:
+    Type() = default;
+    Type(TypeKind kind) : Kind(kind) {}
+
+    static Type getParam(std::string_view name) {
+        Type type(TypeKind::Param);
+        type.Name = name;
+        return type;
+    }
+
+    static Type getStruct(std::string_view name) {
+        Type type(TypeKind::Struct);
+        type.Name = name;
+        return type;
+    }
+
+    static Type getArray(Type element, uint64_t length) {
+        Type type(TypeKind::Array);
+        type.Element = std::make_shared<const Type>(std::move(element));
+        type.Length = length;
+        return type;
+    }
+
+    static Type getSlice(Type element) {
+        Type type(TypeKind::Slice);
+        type.Element = std::make_shared<const Type>(std::move(element));
+        return type;
+    }
+
+    TypeKind getKind() const { return Kind; }
+    bool isVoid() const { return Kind == TypeKind::Void; }
+    bool isParam() const { return Kind == TypeKind::Param; }
+    bool isStruct() const { return Kind == TypeKind::Struct; }
+    bool isArray() const { return Kind == TypeKind::Array; }
+    bool isSlice() const { return Kind == TypeKind::Slice; }
+
+    // The name of a type parameter or struct, as a view into the source.
+    std::string_view getIdentifier() const { return Name; }
+
+    const Type& getElementType() const { return *Element; }
+    uint64_t getLength() const { return Length; }
+
+    // Structs, arrays and slices. Module interfaces cannot describe them
+    // yet.
+    bool isAggregate() const {
+        return Kind == TypeKind::Struct || Kind == TypeKind::Array || Kind == TypeKind::Slice;
+    }
+
+    // The type as it is spelled in the source.
+    std::string getName() const {
+        switch (Kind) {
+            case TypeKind::Void:  return "void";
+            case TypeKind::Str:   return "str";
+            case TypeKind::I64:   return "i64";
+            case TypeKind::Bool:  return "bool";
+            case TypeKind::Param:
+            case TypeKind::Struct: return std::string(Name);
+            case TypeKind::Array:
+                return "[" + Element->getName() + "; " + std::to_string(Length) + "]";
+            case TypeKind::Slice:
+                return "[]" + Element->getName();
+        }
+        return "?";
+    }
+
+    bool operator==(const Type& other) const {
+        if (Kind != other.Kind || Name != other.Name || Length != other.Length) {
+            return false;
+        }
+        return !Element || *Element == *other.Element;
+    }
+    bool operator!=(const Type& other) const { return !(*this == other); }
+    bool operator<(const Type& other) const {
+        if (Kind != other.Kind) {
+            return Kind < other.Kind;
+        }
+        if (Name != other.Name) {
+            return Name < other.Name;
+        }
+        if (Length != other.Length) {
+            return Length < other.Length;
+        }
+        return Element && *Element < *other.Element;
+    }
+};
+
+} // namespace sa
@@ -10,12 +10,30 @@ namespace sa {
 
 // Forward declarations of all AST node types
 class FunctionDecl;
+class ImportDecl;
 class VarDecl;
+class StructDecl;
 class DeclStmt;
 class ExprStmt;
+class SpawnStmt;
+class JoinStmt;
+class RegionStmt;
+class ReturnStmt;
+class IfStmt;
+class AssignStmt;
+class WhileStmt;
+class ForStmt;
 class StringLiteralExpr;
+class IntegerLiteralExpr;
+class BoolLiteralExpr;
+class BinaryExpr;
 class VariableExpr;
 class CallExpr;
+class StructLiteralExpr;
+class FieldExpr;
+class IndexExpr;
+class SliceExpr;
+class AwaitExpr;
 
 // The Visitor base class defines the interface for visiting AST nodes.
 // Any class that wants to traverse the AST should inherit from this class
@@ -27,15 +45,33 @@ public:
     // Declaration visitors
     virtual void visit(FunctionDecl& decl) = 0;
     virtual void visit(VarDecl& decl) = 0;
+    virtual void visit(ImportDecl& decl) = 0;
+    virtual void visit(StructDecl& decl) = 0;
 
     // Statement visitors
     virtual void visit(DeclStmt& stmt) = 0;
     virtual void visit(ExprStmt& stmt) = 0;
+    virtual void visit(SpawnStmt& stmt) = 0;
+    virtual void visit(JoinStmt& stmt) = 0;
+    virtual void visit(RegionStmt& stmt) = 0;
+    virtual void visit(ReturnStmt& stmt) = 0;
+    virtual void visit(IfStmt& stmt) = 0;
+    virtual void visit(AssignStmt& stmt) = 0;
+    virtual void visit(WhileStmt& stmt) = 0;
+    virtual void visit(ForStmt& stmt) = 0;
 
     // Expression visitors
     virtual void visit(StringLiteralExpr& expr) = 0;
+    virtual void visit(IntegerLiteralExpr& expr) = 0;
+    virtual void visit(BoolLiteralExpr& expr) = 0;
+    virtual void visit(BinaryExpr& expr) = 0;
     virtual void visit(VariableExpr& expr) = 0;
     virtual void visit(CallExpr& expr) = 0;
+    virtual void visit(StructLiteralExpr& expr) = 0;
+    virtual void visit(FieldExpr& expr) = 0;
+    virtual void visit(IndexExpr& expr) = 0;
+    virtual void visit(SliceExpr& expr) = 0;
+    virtual void visit(AwaitExpr& expr) = 0;
 };
 
 } // namespace sa
\ No newline at end of file
@@ -20,6 +20,14 @@ void VarDecl::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
 
+void ImportDecl::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void StructDecl::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
 // Statement accept methods
 void DeclStmt::accept(Visitor& visitor) {
     visitor.visit(*this);
@@ -29,11 +37,55 @@ void ExprStmt::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
 
+void SpawnStmt::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void JoinStmt::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void RegionStmt::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void ReturnStmt::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void IfStmt::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void AssignStmt::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void WhileStmt::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void ForStmt::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
 // Expression accept methods
 void StringLiteralExpr::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
 
+void IntegerLiteralExpr::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void BoolLiteralExpr::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void BinaryExpr::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
 void VariableExpr::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
@@ -42,4 +94,24 @@ void CallExpr::accept(Visitor& visitor) {
     visitor.visit(*this);
 }
 
+void StructLiteralExpr::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void FieldExpr::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void IndexExpr::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void SliceExpr::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
+void AwaitExpr::accept(Visitor& visitor) {
+    visitor.visit(*this);
+}
+
 } // namespace sa
\ No newline at end of file
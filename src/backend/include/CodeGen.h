@@ -17,20 +17,80 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/IRBuilder.h"
 #include "llvm/IR/Module.h"
+#include "llvm/Target/TargetMachine.h"
 
+#include <deque>
 #include <map>
+#include <set>
 #include <string_view>
 
 namespace sa {
 
+struct AsyncIOOperation;
+
+// Whether array and slice accesses are checked against the length
+// ('--bounds-checks='). Checks the front end proved unnecessary are
+// never emitted.
+enum class BoundsCheckMode {
+    On,
+    Off,
+    Stats, // On, and print how many checks each function kept.
+};
+
+// What the generated code is compiled for. Left empty, the module targets
+// the default 'arm64-apple-macos'.
+struct CodeGenOptions {
+    // The target triple. Defaults to the host's if only a CPU is given.
+    std::string TargetTriple;
+
+    // The CPU to tune for and whose instructions may be used, or "native"
+    // for the CPU (and features) of the machine running the compiler.
+    std::string CPU;
+
+    BoundsCheckMode BoundsChecks = BoundsCheckMode::On;
+
+    // How hard to optimize, from 0 to 3 ('-O0' to '-O3').
+    unsigned OptLevel = 0;
+};
+
+// The forms the generated code can be written in ('--emit=').
+enum class OutputKind {
+    LLVMIR,      // Textual LLVM IR (.ll).
+    LLVMBitcode, // LLVM bitcode (.bc).
+    Assembly,    // Native assembly (.s).
+    Object,      // A native object file (.o).
+};
+
 class CodeGen : public Visitor {
 public:
     // Constructor.
-    CodeGen();
+    explicit CodeGen(const CodeGenOptions& options = CodeGenOptions());
 
     // The main entry point to generate code for the entire AST.
     void run(const std::vector<std::unique_ptr<Decl>>& ast);
 
+    // The same in steps, for the streaming pipeline, which holds only one
+    // function body at a time: begin(), declare() every top-level
+    // declaration, emit() each function, and finish(). A function needs
+    // only its signature to be declared, so that calls to it can be
+    // generated before its body has been parsed; structs and imports are
+    // generated completely. A function's body may be freed once it has
+    // been emitted, except for a generic function's, which is instantiated
+    // from finish().
+    void begin();
+    void declare(Decl& decl);
+    void emit(FunctionDecl& decl);
+    void finish();
+
+    // Writes the generated module to 'path', or to stdout if it is "-".
+    // With 'stream', bitcode is flushed to the file while it is being
+    // written instead of being built up in memory first. Prints an error
+    // and returns false on failure.
+    bool emitOutput(const std::string& path, OutputKind kind, bool stream = false);
+
+    // The target the module is compiled for.
+    llvm::Triple getTargetTriple() const;
+
 private:
     // --- LLVM Core Objects ---
     // The LLVMContext is a core LLVM data structure that owns and manages
@@ -44,25 +104,336 @@ private:
     // A Module is the top-level container for all other LLVM IR objects.
     std::unique_ptr<llvm::Module> TheModule;
 
+    // The machine the module is compiled for, created when first needed.
+    std::unique_ptr<llvm::TargetMachine> TheTargetMachine;
+
+    // The LLVM type of 'str' values: '%str = type { ptr, i64 }'.
+    llvm::StructType* StrTy;
+
+    // The CPU and feature string every function is compiled with.
+    std::string TargetCPU;
+    std::string TargetFeatures;
+
+    BoundsCheckMode BoundsChecks;
+    unsigned OptLevel;
+
+    // The accesses of each generated function, by how their bounds check
+    // was handled, for '--bounds-checks=stats'.
+    struct BoundsCheckStats {
+        unsigned Removed = 0;
+        unsigned Hoisted = 0;
+        unsigned Kept = 0;
+    };
+    std::map<std::string, BoundsCheckStats> BoundsStats;
+
     // --- Symbol Table ---
     // This map keeps track of which named values are in the current scope.
     // In our simple case, it will map variable names to their memory location.
     std::map<std::string_view, llvm::Value*> NamedValues;
 
+    // The functions defined in this module by name, as declare() saw them
+    // first, so that a second definition is rejected.
+    std::map<std::string_view, FunctionDecl*> DefinedFunctions;
+
+    // The function whose body is currently being generated.
+    FunctionDecl* CurrentFunction = nullptr;
+
+    // The runtime task group of the current function, a counter created in
+    // its entry block. Null if the function spawns nothing.
+    llvm::Value* TaskGroup = nullptr;
+
+    // Names declared inside a 'region' block of the current function that
+    // have gone out of scope, for a better diagnostic if they are used.
+    std::set<std::string_view> RegionScopedNames;
+
+    // Imported modules whose declarations are already in TheModule.
+    std::set<const ModuleFile*> EmittedModules;
+
+    // The default clone of each function with target clones, mapped to the
+    // ifunc that calls must go through instead.
+    std::map<llvm::Function*, llvm::GlobalIFunc*> CloneDispatchers;
+
+    // The 'region' blocks the current statement is nested in, innermost
+    // last. A 'return' must leave all of them.
+    std::vector<llvm::Value*> ActiveRegions;
+
+    // --- Async Functions ---
+    // Every async function is a coroutine that returns its handle. What it
+    // returns in the source is left in its promise, '{ ptr, i8, T }': the
+    // handle of the coroutine awaiting it, whether it has finished or been
+    // detached, and the result. These are the promise types of the async
+    // functions declared so far.
+    std::map<llvm::Function*, llvm::StructType*> AsyncFunctions;
+
+    // The coroutine the current async function is generated as, if any.
+    struct Coroutine {
+        llvm::Value* Id = nullptr;
+        llvm::Value* Handle = nullptr;
+        llvm::AllocaInst* Promise = nullptr;
+        llvm::StructType* PromiseTy = nullptr;
+        // Where a 'return' goes once the result is stored, where the frame
+        // is freed, and where control goes back to whoever started or last
+        // resumed the coroutine.
+        llvm::BasicBlock* Final = nullptr;
+        llvm::BasicBlock* Cleanup = nullptr;
+        llvm::BasicBlock* Suspend = nullptr;
+    };
+    std::unique_ptr<Coroutine> CurrentCoroutine;
+
+    // The 'await' that makes up the statement being generated, whose result
+    // is thrown away. Only there may it await a void async function.
+    const AwaitExpr* DiscardedAwait = nullptr;
+
+    // --- Generics ---
+    // Generic functions by name. They generate no code until called.
+    std::map<std::string_view, FunctionDecl*> GenericFunctions;
+
+    // Every instantiation created so far, keyed by the generic function and
+    // its type arguments, so that each one is generated only once.
+    std::map<std::pair<const FunctionDecl*, std::vector<Type>>, llvm::Function*> Specializations;
+
+    // Instantiations whose bodies still have to be generated. A call only
+    // declares the instantiation; its body is generated once the current
+    // function is done, from run().
+    struct Instantiation {
+        FunctionDecl* Decl;
+        std::vector<Type> TypeArgs;
+        llvm::Function* F;
+    };
+    std::deque<Instantiation> InstantiationQueue;
+
+    // What the type parameters stand for in the instantiation whose
+    // signature or body is being generated.
+    std::map<std::string_view, Type> TypeSubstitution;
+
+    // --- Structs ---
+    struct StructInfo {
+        StructDecl* Decl;
+        llvm::StructType* Ty;
+        // The element of Ty each field of Decl is stored in, by field.
+        std::vector<unsigned> FieldIndices;
+    };
+    std::map<std::string_view, StructInfo> Structs;
+
+    // The 'sa' types of the struct, array and slice LLVM types created so
+    // far.
+    std::map<llvm::Type*, Type> AggregateTypes;
+
+    // Where a value is stored: a variable, or a field or element of one.
+    struct Place {
+        llvm::Value* Addr = nullptr;
+        Type Ty;
+        // Only for an element of a '@soa' array, which is not stored in one
+        // piece: Addr points to the array's columns and each field of the
+        // element is at Index in its column.
+        llvm::StructType* Columns = nullptr;
+        llvm::Value* Index = nullptr;
+    };
+
+    // Returns TheTargetMachine, creating it for the module's triple first if
+    // needed. Exits if LLVM does not support the triple.
+    llvm::TargetMachine* getTargetMachine();
+
     // --- Visitor Methods ---
     // We will override the 'visit' method for each of our AST node types
     // to generate the corresponding LLVM IR.
     void visit(FunctionDecl& decl) override;
     void visit(VarDecl& decl) override;
+    void visit(ImportDecl& decl) override;
+    void visit(StructDecl& decl) override;
     void visit(DeclStmt& stmt) override;
     void visit(ExprStmt& stmt) override;
+    void visit(SpawnStmt& stmt) override;
+    void visit(JoinStmt& stmt) override;
+    void visit(RegionStmt& stmt) override;
+    void visit(ReturnStmt& stmt) override;
+    void visit(IfStmt& stmt) override;
+    void visit(AssignStmt& stmt) override;
+    void visit(WhileStmt& stmt) override;
+    void visit(ForStmt& stmt) override;
     void visit(StringLiteralExpr& expr) override;
+    void visit(IntegerLiteralExpr& expr) override;
+    void visit(BoolLiteralExpr& expr) override;
+    void visit(BinaryExpr& expr) override;
     void visit(VariableExpr& expr) override;
     void visit(CallExpr& expr) override;
+    void visit(StructLiteralExpr& expr) override;
+    void visit(FieldExpr& expr) override;
+    void visit(IndexExpr& expr) override;
+    void visit(SliceExpr& expr) override;
+    void visit(AwaitExpr& expr) override;
 
     // We will need a way to get the result of visiting an expression.
     // This will be crucial.
     llvm::Value* visitExpression(Expr* expr);
+
+    // Maps the '@inline', '@hot', ... annotations of a function onto LLVM
+    // function attributes and section placement.
+    void applyFunctionAttrs(const FunctionDecl& decl, llvm::Function* F);
+
+    // The LLVM type of values of 'type'. Type parameters are looked up in
+    // TypeSubstitution. Prints an error and returns null for an unknown
+    // struct.
+    llvm::Type* getLLVMType(const Type& type);
+
+    // The columns of an array of '@soa' struct 'info': one array per field,
+    // in declaration order.
+    llvm::StructType* getSoAColumnsType(const StructInfo& info, uint64_t length);
+
+    // The alloca of the variable 'name', or null after printing an error.
+    llvm::AllocaInst* lookupVariable(std::string_view name);
+
+    // Computes where 'expr' is stored. A value that is not stored anywhere,
+    // like the result of a call, is stored into a temporary first. Prints
+    // an error and returns false on failure.
+    bool emitPlace(Expr& expr, Place& place);
+    llvm::Value* loadPlace(const Place& place);
+    void storePlace(const Place& place, llvm::Value* value);
+
+    // Narrows 'place', a struct, to its field 'name'. Prints an error and
+    // returns false if there is no such field.
+    bool emitFieldPlace(Place& place, std::string_view name);
+
+    // The number of elements of the array, slice or 'str' at 'place'.
+    llvm::Value* emitLength(const Place& place);
+
+    // The LLVM type of slices of 'element': '%"[]T" = type { ptr, i64 }'.
+    llvm::StructType* getSliceType(const Type& element);
+
+    // Whether values of 'type' are a pointer and a length: a 'str' or a
+    // slice.
+    bool isFatPointer(llvm::Type* type);
+
+    // Continues in a new block if 'inBounds' holds, and otherwise reports
+    // 'index' and 'length' to the runtime, which aborts.
+    void emitBoundsCheck(llvm::Value* inBounds, llvm::Value* index, llvm::Value* length);
+
+    // Continues in a new block if 'dividend' can be divided by 'divisor',
+    // and otherwise reports both to the runtime, which aborts.
+    void emitDivisionCheck(llvm::Value* dividend, llvm::Value* divisor);
+
+    // The bounds statistics of the function being generated.
+    BoundsCheckStats& getBoundsStats();
+
+    // Ends the current block with a branch to 'dest', unless it already
+    // ends or nothing jumps to it (it follows a 'return').
+    void emitBranch(llvm::BasicBlock* dest);
+
+    // The 'sa' type of values of the LLVM type 'type'.
+    Type getTypeOf(llvm::Type* type);
+
+    // The LLVM signature of 'decl', or null if it names an unknown struct.
+    // A 'str' or slice parameter is passed as two arguments, the pointer
+    // and the length, which is also how C passes a struct of the two on
+    // the targets we support.
+    llvm::FunctionType* getFunctionType(const FunctionDecl& decl);
+
+    // Appends 'value' to 'args' as it is passed to a function: a 'str' is
+    // or slice is split into its pointer and length.
+    void appendLoweredArg(llvm::Value* value, std::vector<llvm::Value*>& args);
+
+    // Evaluates the arguments of 'call' into 'args', lowered for the
+    // callee, and returns the function to call: the one with the callee's
+    // name, or the instantiation of a generic function for the argument
+    // types. Prints an error and returns null if there is no such function
+    // or the arguments do not match its parameters.
+    llvm::Function* emitCallee(CallExpr& call, std::vector<llvm::Value*>& args);
+
+    // Infers the type arguments of generic 'decl' from the values passed to
+    // it, and returns the matching instantiation.
+    llvm::Function* instantiateFor(FunctionDecl& decl, CallExpr& call,
+                                   const std::vector<llvm::Value*>& values);
+
+    // Returns the instantiation of 'decl' for 'typeArgs', declaring it and
+    // queueing its body the first time it is asked for.
+    llvm::Function* instantiate(FunctionDecl& decl, const std::vector<Type>& typeArgs);
+
+    // Maps the type parameters of 'decl' to 'typeArgs'.
+    static std::map<std::string_view, Type> bindTypeArgs(const FunctionDecl& decl,
+                                                         const std::vector<Type>& typeArgs);
+
+    // Generates the statements of a block. Names declared in it end with it.
+    void emitBlock(const std::vector<std::unique_ptr<Stmt>>& stmts);
+
+    // Leaves the current function: waits for its tasks, leaves the regions
+    // it is in and returns 'value', or nothing if it is null.
+    void emitReturn(llvm::Value* value);
+
+    // Generates the body of 'decl' into the empty function 'F'.
+    void emitFunctionBody(FunctionDecl& decl, llvm::Function* F);
+
+    // Whether 'decl' is compiled once per '@target_clones' entry: only for
+    // x86-64 ELF targets, and never for 'main' or async functions, which
+    // visit(FunctionDecl) reports.
+    bool hasTargetClones(const FunctionDecl& decl) const;
+
+    // Declares one clone of 'decl' per '@target_clones' entry and an ifunc
+    // that picks the best of them for the running CPU at load time, so that
+    // calls can go through it before the clones are generated.
+    void declareTargetClones(FunctionDecl& decl, llvm::FunctionType* FT);
+
+    // Generates the body of every clone declareTargetClones created.
+    void emitTargetClones(FunctionDecl& decl);
+
+    // Returns an internal function that executes 'cpuid' and returns a mask
+    // of the TargetClone features the running CPU and OS support.
+    llvm::Function* getCPUFeaturesFunction();
+
+    // Looks up a function by its source name. For a function with target
+    // clones this is the default clone.
+    llvm::Function* lookupFunction(std::string_view name);
+
+    // What calls to 'F' go through: 'F' itself or its ifunc.
+    llvm::FunctionCallee getCallee(llvm::Function* F);
+
+    // Creates an alloca in the entry block of the current function, so that
+    // it is allocated once however often the code using it runs.
+    llvm::AllocaInst* createEntryBlockAlloca(llvm::Type* type, const llvm::Twine& name);
+
+    // Whether 'stmts' spawn a task on the scheduler anywhere, not counting
+    // async functions, which run on the event loop instead.
+    bool spawnsTasks(const std::vector<std::unique_ptr<Stmt>>& stmts);
+
+    // Returns an internal 'void(ptr)' function that unpacks a spawn
+    // environment holding the callee's arguments and calls it.
+    llvm::Function* getSpawnThunk(llvm::Function* callee);
+
+    // The promise of an async function returning 'result', or void.
+    llvm::StructType* getPromiseType(llvm::Type* result);
+    llvm::Align getPromiseAlign(llvm::StructType* promiseTy);
+
+    // Records that 'F' is the coroutine of async function 'decl'.
+    void declareAsync(const FunctionDecl& decl, llvm::Function* F);
+
+    // Turns the current function into a coroutine: allocates its frame and
+    // creates the blocks of CurrentCoroutine, which emitCoroutineEnd()
+    // fills in once the body has been generated.
+    void emitCoroutineBegin(llvm::StructType* promiseTy);
+    void emitCoroutineEnd();
+
+    // Suspends the current coroutine and continues in 'resume' once it is
+    // resumed.
+    void emitSuspend(llvm::BasicBlock* resume);
+
+    // Lets the coroutine 'handle' of an async function with promise
+    // 'promiseTy' run on by itself: it frees itself when it finishes.
+    void emitDetach(llvm::Value* handle, llvm::StructType* promiseTy);
+
+    // Awaits one of the runtime's I/O operations, retrying it whenever the
+    // descriptor it waits for becomes ready.
+    void emitAwaitIO(CallExpr& call, const AsyncIOOperation& op);
+
+    // Generates the 'main' that runs async 'main' on the event loop.
+    void emitAsyncMain(FunctionDecl& decl, llvm::Function* Main);
+
+    // Runs LLVM's standard pipeline for OptLevel over the module. At every
+    // level this splits each coroutine into the functions that start,
+    // resume and destroy it, the only form the code generator accepts.
+    void optimize();
+
+    // Declares the exported functions of an imported module (and, first, of
+    // the modules it depends on).
+    void emitImportedModule(ModuleFile& module);
 };
 
 } // namespace sa
\ No newline at end of file
@@ -0,0 +1,35 @@
+//===--- Linker.h - In-process Linking of 'sa' Programs ---------*- C++ -*-===//
+//
+// This file declares linkExecutable, which links object files and the 'sa'
+// runtime into an executable by calling into the lld library, instead of
+// running a separate linker with a hand-written command line.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "llvm/TargetParser/Triple.h"
+#include <string>
+#include <vector>
+
+namespace sa {
+
+// The runtimes an executable can be linked with ('--runtime=').
+enum class RuntimeKind {
+    // runtime/*.c, on top of the host C library, linked as a PIE.
+    Full,
+    // runtime/minimal.c and nothing else, linked statically: no dynamic
+    // loader and no libc start-up, but also no threads. Linux only.
+    Minimal,
+};
+
+// Links 'objects' with the runtime archive that ships with the compiler
+// and, for the full runtime, the host C library into the executable
+// 'outputPath'. 'argv0' is the compiler's own argv[0], which the runtime
+// archive is found relative to. Only ELF targets matching the host are
+// supported. Prints an error and returns false on failure.
+bool linkExecutable(const std::vector<std::string>& objects, const std::string& outputPath,
+                    const llvm::Triple& triple, const char* argv0,
+                    RuntimeKind runtime = RuntimeKind::Full);
+
+} // namespace sa
@@ -4,54 +4,379 @@
 //
 //===----------------------------------------------------------------------===//
 #include "backend/include/CodeGen.h"
+#include "serialization/include/ModuleReader.h"
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <numeric>
 #include <vector>
 
 // --- LLVM Headers ---
+#include "llvm/Analysis/ValueTracking.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/InlineAsm.h"
+#include "llvm/IR/Intrinsics.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/MDBuilder.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/IR/Type.h"
+#include "llvm/MC/TargetRegistry.h"
+#include "llvm/Passes/PassBuilder.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/TargetSelect.h"
+#include "llvm/TargetParser/Host.h"
 #include "llvm/TargetParser/Triple.h"
+#include "llvm/Transforms/Coroutines/CoroCleanup.h"
+#include "llvm/Transforms/Coroutines/CoroEarly.h"
+#include "llvm/Transforms/Coroutines/CoroSplit.h"
 
 namespace sa {
 
 // A global map to hold the result of visiting an expression.
 static llvm::Value* V;
 
-CodeGen::CodeGen() {
+// Output files are written in blocks this big rather than the file
+// system's preferred size, which is usually only a few KiB.
+static constexpr size_t OutputBufferSize = 1 << 20;
+
+// The instruction sets '@target_clones' accepts on x86-64, from the most to
+// the least preferred. Each one's bit in the mask __sa_cpu_features returns
+// is its index here.
+struct TargetClone {
+    const char* Name;
+    const char* Features; // Added to the function's target features.
+};
+static const TargetClone TargetClones[] = {
+    {"avx512f", "+avx512f"},
+    {"avx2", "+avx2"},
+    {"fma", "+fma"},
+    {"avx", "+avx"},
+    {"sse4.2", "+sse4.2"},
+};
+
+// The bits of the state byte in an async function's promise.
+enum PromiseState : uint8_t {
+    PS_Done = 1,     // It has returned; the result is in the promise.
+    PS_Detached = 2, // Nothing awaits it; it frees its own frame when done.
+};
+
+// What the runtime's I/O operations return instead of blocking; see
+// runtime/async.c.
+static constexpr int64_t IOPending = std::numeric_limits<int64_t>::min();
+
+// The socket operations 'await' accepts without a declaration. Each is a
+// runtime function that returns IOPending when it would block, in which
+// case the coroutine waits for its descriptor, the first argument, and
+// calls it again.
+struct AsyncIOOperation {
+    const char* Name;
+    const char* Function;
+    bool Writes;     // Waits for the descriptor to be writable, not readable.
+    bool ReturnsStr; // Returns a length and stores the data pointer.
+};
+static const AsyncIOOperation AsyncIOOperations[] = {
+    {"accept", "sa_io_accept", false, false},
+    {"read", "sa_io_read", false, true},
+    {"write", "sa_io_write", true, false},
+};
+
+static const AsyncIOOperation* findAsyncIOOperation(std::string_view name) {
+    for (const AsyncIOOperation& op : AsyncIOOperations) {
+        if (name == op.Name) {
+            return &op;
+        }
+    }
+    return nullptr;
+}
+
+// Runtime functions 'sa' code calls by another name, because the C library
+// already has one by the name 'sa' uses.
+static const std::pair<std::string_view, const char*> RuntimeAliases[] = {
+    {"listen", "sa_tcp_listen"},
+    {"connect", "sa_tcp_connect"},
+    {"close", "sa_io_close"},
+};
+
+CodeGen::CodeGen(const CodeGenOptions& options) {
     TheContext = std::make_unique<llvm::LLVMContext>();
     TheModule = std::make_unique<llvm::Module>("sa_module", *TheContext);
     Builder = std::make_unique<llvm::IRBuilder<>>(*TheContext);
+    StrTy = llvm::StructType::create(*TheContext, {Builder->getPtrTy(), Builder->getInt64Ty()}, "str");
+    BoundsChecks = options.BoundsChecks;
+    OptLevel = options.OptLevel;
+
+    if (options.TargetTriple.empty() && options.CPU.empty()) {
+        // Set the target triple so LLVM emits macOS-compatible ARM64 objects
+        llvm::Triple triple("arm64-apple-macos");
+        TheModule->setTargetTriple(triple);
+
+        // Set the data layout for macOS ARM64
+        TheModule->setDataLayout("e-m:o-i64:64-i128:128-n32:64-S128");
+        return;
+    }
+
+    // An explicit target or CPU: ask LLVM for the machine, which knows the
+    // data layout and what the CPU name stands for.
+    llvm::Triple triple(options.TargetTriple.empty() ? llvm::sys::getProcessTriple()
+                                                     : options.TargetTriple);
+    TargetCPU = options.CPU;
+    if (TargetCPU == "native") {
+        TargetCPU = llvm::sys::getHostCPUName().str();
+        llvm::StringMap<bool> HostFeatures = llvm::sys::getHostCPUFeatures();
+        for (const auto& feature : HostFeatures) {
+            if (!TargetFeatures.empty()) {
+                TargetFeatures += ',';
+            }
+            TargetFeatures += (feature.second ? "+" : "-") + feature.first().str();
+        }
+    }
 
-    // Set the target triple so LLVM emits macOS-compatible ARM64 objects
-    llvm::Triple triple("arm64-apple-macos");
     TheModule->setTargetTriple(triple);
-    
-    // Set the data layout for macOS ARM64
-    TheModule->setDataLayout("e-m:o-i64:64-i128:128-n32:64-S128");
+    TheModule->setDataLayout(getTargetMachine()->createDataLayout());
+}
+
+llvm::TargetMachine* CodeGen::getTargetMachine() {
+    if (TheTargetMachine) {
+        return TheTargetMachine.get();
+    }
+
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmPrinters();
+    llvm::InitializeAllAsmParsers();
+
+    llvm::Triple triple = getTargetTriple();
+    std::string Error;
+    const llvm::Target* Target = llvm::TargetRegistry::lookupTarget(triple.str(), Error);
+    if (!Target) {
+        std::cerr << "CodeGen Error: " << Error << std::endl;
+        exit(1);
+    }
+    TheTargetMachine.reset(Target->createTargetMachine(triple, TargetCPU, TargetFeatures,
+                                                       llvm::TargetOptions(), llvm::Reloc::PIC_));
+    return TheTargetMachine.get();
+}
+
+llvm::Triple CodeGen::getTargetTriple() const {
+    return llvm::Triple(TheModule->getTargetTriple());
 }
 
 void CodeGen::run(const std::vector<std::unique_ptr<Decl>>& ast) {
+    begin();
+    for (const auto& decl : ast) {
+        declare(*decl);
+    }
+    for (const auto& decl : ast) {
+        if (auto* fn = dynamic_cast<FunctionDecl*>(decl.get())) {
+            emit(*fn);
+        }
+    }
+    finish();
+}
+
+void CodeGen::begin() {
     // --- The External 'print' Function ---
-    // We assume it's like a C `void print(char*)`. In modern LLVM, this is `void(ptr)`.
+    // It takes a 'str', so in C it is `void print(const char*, int64_t len)`.
+    // In modern LLVM, this is `void(ptr, i64)`.
 
     // 1. Get the modern opaque pointer type `ptr`.
     llvm::Type* PtrType = Builder->getPtrTy();
 
-    // 2. Define the function type: `void(ptr)`.
+    // 2. Define the function type: `void(ptr, i64)`.
     llvm::FunctionType* PrintFuncType = llvm::FunctionType::get(
-        Builder->getVoidTy(), {PtrType}, false);
+        Builder->getVoidTy(), {PtrType, Builder->getInt64Ty()}, false);
 
     // 3. Declare the function in our LLVM Module.
     TheModule->getOrInsertFunction("print", PrintFuncType);
 
-    // --- The Main Code Generation Loop ---
-    for (const auto& decl : ast) {
-        decl->accept(*this);
+    // --- The Task Scheduler ---
+    // void sa_spawn(sa_task_group*, void (*)(void*), const void* env, size_t)
+    // void sa_join(sa_task_group*)
+    llvm::FunctionType* SpawnFuncType = llvm::FunctionType::get(
+        Builder->getVoidTy(), {PtrType, PtrType, PtrType, Builder->getInt64Ty()}, false);
+    TheModule->getOrInsertFunction("sa_spawn", SpawnFuncType);
+    llvm::FunctionType* JoinFuncType = llvm::FunctionType::get(
+        Builder->getVoidTy(), {PtrType}, false);
+    TheModule->getOrInsertFunction("sa_join", JoinFuncType);
+
+    // --- The Region Allocator ---
+    // void sa_region_enter(sa_region*), void sa_region_exit(sa_region*)
+    llvm::FunctionType* RegionFuncType = llvm::FunctionType::get(
+        Builder->getVoidTy(), {PtrType}, false);
+    TheModule->getOrInsertFunction("sa_region_enter", RegionFuncType);
+    TheModule->getOrInsertFunction("sa_region_exit", RegionFuncType);
+
+    // --- Bounds Checks ---
+    // void sa_bounds_fail(int64_t index, int64_t length), which aborts.
+    llvm::FunctionType* BoundsFailFuncType = llvm::FunctionType::get(
+        Builder->getVoidTy(), {Builder->getInt64Ty(), Builder->getInt64Ty()}, false);
+    llvm::Function* BoundsFail = llvm::cast<llvm::Function>(
+        TheModule->getOrInsertFunction("sa_bounds_fail", BoundsFailFuncType).getCallee());
+    BoundsFail->setDoesNotReturn();
+    BoundsFail->setDoesNotThrow();
+    BoundsFail->addFnAttr(llvm::Attribute::Cold);
+
+    // void sa_div_fail(int64_t dividend, int64_t divisor), which aborts.
+    llvm::Function* DivFail = llvm::cast<llvm::Function>(
+        TheModule->getOrInsertFunction("sa_div_fail", BoundsFailFuncType).getCallee());
+    DivFail->setDoesNotReturn();
+    DivFail->setDoesNotThrow();
+    DivFail->addFnAttr(llvm::Attribute::Cold);
+
+    // --- Async Functions ---
+    // Coroutine frames come from the size-class pools (runtime/alloc.h);
+    // the event loop and the socket operations are in runtime/async.c.
+    llvm::Type* I64 = Builder->getInt64Ty();
+    llvm::Type* VoidTy = Builder->getVoidTy();
+    TheModule->getOrInsertFunction("sa_pool_alloc", llvm::FunctionType::get(PtrType, {I64}, false));
+    TheModule->getOrInsertFunction("sa_pool_free", llvm::FunctionType::get(VoidTy, {PtrType, I64}, false));
+    TheModule->getOrInsertFunction("sa_async_ready", llvm::FunctionType::get(VoidTy, {PtrType}, false));
+    TheModule->getOrInsertFunction("sa_async_run", llvm::FunctionType::get(VoidTy, false));
+    TheModule->getOrInsertFunction("sa_io_wait", llvm::FunctionType::get(VoidTy, {I64, I64, PtrType}, false));
+    TheModule->getOrInsertFunction("sa_tcp_listen", llvm::FunctionType::get(I64, {I64}, false));
+    TheModule->getOrInsertFunction("sa_tcp_connect", llvm::FunctionType::get(I64, {I64}, false));
+    TheModule->getOrInsertFunction("sa_io_close", llvm::FunctionType::get(VoidTy, {I64}, false));
+    TheModule->getOrInsertFunction("sa_io_accept", llvm::FunctionType::get(I64, {I64}, false));
+    TheModule->getOrInsertFunction("sa_io_read", llvm::FunctionType::get(I64, {I64, PtrType}, false));
+    TheModule->getOrInsertFunction("sa_io_write", llvm::FunctionType::get(I64, {I64, PtrType, I64}, false));
+}
+
+void CodeGen::declare(Decl& decl) {
+    auto* fn = dynamic_cast<FunctionDecl*>(&decl);
+
+    // A second definition would add its body to the first one's function,
+    // or to that of an import or runtime function by the same name.
+    if (fn && !fn->isImported()) {
+        if (DefinedFunctions.count(fn->getName())) {
+            std::cerr << "CodeGen Error: Function '" << fn->getName()
+                      << "' is defined more than once." << std::endl;
+            return;
+        }
+        if (TheModule->getNamedValue(fn->getName())) {
+            std::cerr << "CodeGen Error: Function '" << fn->getName()
+                      << "' is already declared by an import or the runtime." << std::endl;
+            return;
+        }
+        DefinedFunctions.emplace(fn->getName(), fn);
+    }
+
+    if (!fn || fn->isGeneric()) {
+        decl.accept(*this);
+        return;
+    }
+
+    if (TheModule->getFunction(fn->getName())) {
+        return;
+    }
+    llvm::FunctionType* FT = getFunctionType(*fn);
+    if (!FT) {
+        return;
+    }
+    // A function with target clones is declared as its clones and the ifunc
+    // that picks one.
+    if (hasTargetClones(*fn)) {
+        declareTargetClones(*fn, FT);
+        return;
+    }
+    llvm::Function* F = llvm::Function::Create(FT, llvm::Function::ExternalLinkage,
+                                                fn->getName(), TheModule.get());
+    applyFunctionAttrs(*fn, F);
+    declareAsync(*fn, F);
+}
+
+void CodeGen::emit(FunctionDecl& decl) {
+    // A generic function was registered by declare() and has no code of its
+    // own. A definition declare() rejected has none either.
+    auto defined = DefinedFunctions.find(decl.getName());
+    if (!decl.isGeneric() && defined != DefinedFunctions.end() && defined->second == &decl) {
+        decl.accept(*this);
+    }
+}
+
+void CodeGen::finish() {
+    // Generate the instantiations the calls above asked for. Their bodies
+    // may call further instantiations, which join the end of the queue.
+    while (!InstantiationQueue.empty()) {
+        Instantiation Inst = std::move(InstantiationQueue.front());
+        InstantiationQueue.pop_front();
+        TypeSubstitution = bindTypeArgs(*Inst.Decl, Inst.TypeArgs);
+        emitFunctionBody(*Inst.Decl, Inst.F);
+        TypeSubstitution.clear();
+    }
+
+    optimize();
+
+    if (BoundsChecks == BoundsCheckMode::Stats) {
+        std::cerr << std::left << std::setw(32) << "Bounds checks" << std::right
+                  << std::setw(10) << "removed" << std::setw(10) << "hoisted"
+                  << std::setw(10) << "kept" << std::endl;
+        for (const auto& [name, stats] : BoundsStats) {
+            std::cerr << std::left << std::setw(32) << name << std::right
+                      << std::setw(10) << stats.Removed << std::setw(10) << stats.Hoisted
+                      << std::setw(10) << stats.Kept << std::endl;
+        }
+    }
+}
+
+bool CodeGen::emitOutput(const std::string& path, OutputKind kind, bool stream) {
+    bool isText = kind == OutputKind::LLVMIR || kind == OutputKind::Assembly;
+    llvm::raw_pwrite_stream* Out = &llvm::outs();
+    std::unique_ptr<llvm::raw_fd_ostream> File;
+    if (path != "-") {
+        std::error_code EC;
+        // The bitcode writer only streams into a raw_fd_stream, which can
+        // seek back to fill in block sizes once they are known.
+        if (stream && kind == OutputKind::LLVMBitcode) {
+            File = std::make_unique<llvm::raw_fd_stream>(path, EC);
+        } else {
+            File = std::make_unique<llvm::raw_fd_ostream>(
+                path, EC, isText ? llvm::sys::fs::OF_Text : llvm::sys::fs::OF_None);
+        }
+        if (EC) {
+            std::cerr << "CodeGen Error: Could not open '" << path << "': " << EC.message() << std::endl;
+            return false;
+        }
+        File->SetBufferSize(OutputBufferSize);
+        Out = File.get();
+    }
+
+    switch (kind) {
+        case OutputKind::LLVMIR:
+            TheModule->print(*Out, nullptr);
+            break;
+        case OutputKind::LLVMBitcode:
+            llvm::WriteBitcodeToFile(*TheModule, *Out);
+            break;
+        case OutputKind::Assembly:
+        case OutputKind::Object: {
+            llvm::CodeGenFileType FileType = kind == OutputKind::Assembly
+                ? llvm::CodeGenFileType::AssemblyFile
+                : llvm::CodeGenFileType::ObjectFile;
+            llvm::legacy::PassManager PM;
+            if (getTargetMachine()->addPassesToEmitFile(PM, *Out, nullptr, FileType)) {
+                std::cerr << "CodeGen Error: The target cannot emit this kind of file." << std::endl;
+                return false;
+            }
+            PM.run(*TheModule);
+            break;
+        }
     }
 
-    // After visiting all nodes, print the generated IR to stdout.
-    TheModule->print(llvm::outs(), nullptr);
+    if (File) {
+        File->close();
+        if (File->has_error()) {
+            std::cerr << "CodeGen Error: Could not write '" << path << "': "
+                      << File->error().message() << std::endl;
+            File->clear_error();
+            return false;
+        }
+    }
+    return true;
 }
 
 // --- Visitor Method Implementations ---
@@ -59,94 +384,1966 @@ void CodeGen::visit(FunctionDecl& decl) {
     // Detect if this is the 'main' function
     bool isMain = (decl.getName() == "main");
 
-    // Use int32 return type for main, void otherwise
-    llvm::Type* returnType = isMain ? Builder->getInt32Ty() : Builder->getVoidTy();
+    if (isMain && !decl.getParams().empty()) {
+        std::cerr << "CodeGen Error: 'main' cannot have parameters." << std::endl;
+        return;
+    }
+    if (isMain && !decl.getReturnType().isVoid()) {
+        std::cerr << "CodeGen Error: 'main' cannot return a value." << std::endl;
+        return;
+    }
+    if (decl.isAsync() && decl.hasAttr(FA_Pure)) {
+        std::cerr << "CodeGen Error: Async function '" << decl.getName() << "' cannot be '@pure'."
+                  << std::endl;
+        return;
+    }
+    if (decl.isAsync() && !decl.getTargetClones().empty()) {
+        std::cerr << "CodeGen Error: Async function '" << decl.getName()
+                  << "' cannot have target clones." << std::endl;
+        return;
+    }
+
+    // A generic function is only generated once it is called, for the
+    // types it is called with.
+    if (decl.isGeneric()) {
+        if (isMain) {
+            std::cerr << "CodeGen Error: 'main' cannot be generic." << std::endl;
+        } else if (!decl.getTargetClones().empty()) {
+            std::cerr << "CodeGen Error: Generic function '" << decl.getName()
+                      << "' cannot have target clones." << std::endl;
+        } else {
+            GenericFunctions[decl.getName()] = &decl;
+        }
+        return;
+    }
+
+    llvm::FunctionType* FT = getFunctionType(decl);
+    if (!FT) {
+        return;
+    }
+
+    if (!decl.getTargetClones().empty() && !decl.isImported()) {
+        llvm::Triple triple(TheModule->getTargetTriple());
+        if (isMain) {
+            std::cerr << "CodeGen Error: 'main' cannot have target clones." << std::endl;
+        } else if (triple.getArch() != llvm::Triple::x86_64 || !triple.isOSBinFormatELF()) {
+            std::cerr << "CodeGen Warning: '@target_clones' needs an x86-64 ELF target; '"
+                      << decl.getName() << "' is compiled for the base target only." << std::endl;
+        } else {
+            emitTargetClones(decl);
+            return;
+        }
+    }
 
     // Use the function name as-is; the Mach-O mangling will add underscore automatically
     llvm::Function* TheFunction = TheModule->getFunction(decl.getName());
     if (!TheFunction) {
-        llvm::FunctionType* FT = llvm::FunctionType::get(returnType, false);
         TheFunction = llvm::Function::Create(FT, llvm::Function::ExternalLinkage,
                                              decl.getName(), TheModule.get());
+        applyFunctionAttrs(decl, TheFunction);
+        declareAsync(decl, TheFunction);
+    }
+
+    // An imported function is defined in its own module's object file. If
+    // the interface carried its body, emit it as available_externally so
+    // the optimizer can inline it without us emitting a second definition.
+    if (decl.isImported()) {
+        if (!decl.hasBody() || !TheFunction->empty()) {
+            return;
+        }
+        TheFunction->setLinkage(llvm::Function::AvailableExternallyLinkage);
     }
 
+    if (isMain && decl.isAsync()) {
+        emitAsyncMain(decl, TheFunction);
+        return;
+    }
+    emitFunctionBody(decl, TheFunction);
+}
+
+void CodeGen::emitFunctionBody(FunctionDecl& decl, llvm::Function* TheFunction) {
     llvm::BasicBlock* BB = llvm::BasicBlock::Create(*TheContext, "entry", TheFunction);
     Builder->SetInsertPoint(BB);
     NamedValues.clear();
+    CurrentFunction = &decl;
+    TaskGroup = nullptr;
+    RegionScopedNames.clear();
+    CurrentCoroutine.reset();
+    if (decl.isAsync()) {
+        emitCoroutineBegin(AsyncFunctions.at(TheFunction));
+    }
+
+    // Parameters live in allocas like 'let' variables; a 'str' or slice is
+    // put back together from its two arguments.
+    auto Arg = TheFunction->arg_begin();
+    for (const Param& param : decl.getParams()) {
+        std::string Name(param.Name.lexeme);
+        llvm::Value* Value = Arg++;
+        llvm::Type* ParamTy = getLLVMType(param.Ty);
+        if (isFatPointer(ParamTy)) {
+            Value->setName(Name + ".ptr");
+            Arg->setName(Name + ".len");
+            Value = Builder->CreateInsertValue(llvm::PoisonValue::get(ParamTy), Value, 0);
+            Value = Builder->CreateInsertValue(Value, Arg++, 1);
+        } else {
+            Value->setName(Name);
+        }
+        llvm::AllocaInst* Alloca = createEntryBlockAlloca(Value->getType(), Name);
+        Builder->CreateStore(Value, Alloca);
+        NamedValues[param.Name.lexeme] = Alloca;
+    }
+
+    // Every exit from the function or from a region waits for the tasks
+    // spawned so far. In a loop, an exit that comes before the first
+    // 'spawn' in the text can run after it, so the group has to exist
+    // from the start.
+    if (spawnsTasks(decl.getBody())) {
+        TaskGroup = createEntryBlockAlloca(Builder->getInt64Ty(), "tasks");
+        Builder->CreateStore(Builder->getInt64(0), TaskGroup);
+    }
 
     // Generate function body
     for (const auto& stmt : decl.getBody()) {
         stmt->accept(*this);
     }
 
-    // Return type depends on whether it's main or not
-    if (isMain) {
-        Builder->CreateRet(llvm::ConstantInt::get(Builder->getInt32Ty(), 0));
-    } else {
-        Builder->CreateRetVoid();
+    // Falling off the end returns, unless the end cannot be reached (every
+    // path returned already) or the function has a value to return.
+    llvm::BasicBlock* Last = Builder->GetInsertBlock();
+    if (!Last->getTerminator()) {
+        if (Last != &TheFunction->getEntryBlock() && llvm::pred_empty(Last)) {
+            Builder->CreateUnreachable();
+        } else if (decl.getName() == "main" || decl.getReturnType().isVoid()) {
+            emitReturn(nullptr);
+        } else {
+            std::cerr << "CodeGen Error: '" << decl.getName()
+                      << "' can reach its end without returning a value." << std::endl;
+            Builder->CreateUnreachable();
+        }
+    }
+    if (CurrentCoroutine) {
+        emitCoroutineEnd();
+        CurrentCoroutine.reset();
     }
 
     llvm::verifyFunction(*TheFunction);
+    CurrentFunction = nullptr;
 }
 
-void CodeGen::visit(VarDecl& decl) {
-    decl.getInitializer()->accept(*this);
-    llvm::Value* InitializerValue = V;
+llvm::Type* CodeGen::getLLVMType(const Type& type) {
+    switch (type.getKind()) {
+        case TypeKind::Void: return Builder->getVoidTy();
+        case TypeKind::Str:  return StrTy;
+        case TypeKind::I64:  return Builder->getInt64Ty();
+        case TypeKind::Bool: return Builder->getInt1Ty();
+        case TypeKind::Param: {
+            auto it = TypeSubstitution.find(type.getIdentifier());
+            return it == TypeSubstitution.end() ? nullptr : getLLVMType(it->second);
+        }
+        case TypeKind::Struct: {
+            auto it = Structs.find(type.getIdentifier());
+            if (it == Structs.end()) {
+                std::cerr << "CodeGen Error: Unknown type '" << type.getIdentifier() << "'." << std::endl;
+                return nullptr;
+            }
+            return it->second.Ty;
+        }
+        case TypeKind::Array: {
+            llvm::Type* ElementTy = getLLVMType(type.getElementType());
+            if (!ElementTy) {
+                return nullptr;
+            }
+            Type Element = getTypeOf(ElementTy);
+            llvm::Type* ArrayTy = llvm::ArrayType::get(ElementTy, type.getLength());
+            if (Element.isStruct()) {
+                const StructInfo& Info = Structs.at(Element.getIdentifier());
+                if (Info.Decl->hasAttr(SA_SoA)) {
+                    ArrayTy = getSoAColumnsType(Info, type.getLength());
+                }
+            }
+            AggregateTypes.emplace(ArrayTy, Type::getArray(Element, type.getLength()));
+            return ArrayTy;
+        }
+        case TypeKind::Slice: {
+            llvm::Type* ElementTy = getLLVMType(type.getElementType());
+            return ElementTy ? getSliceType(getTypeOf(ElementTy)) : nullptr;
+        }
+    }
+    return nullptr;
+}
+
+llvm::StructType* CodeGen::getSliceType(const Type& element) {
+    std::string Name = "[]" + element.getName();
+    llvm::StructType* SliceTy = llvm::StructType::getTypeByName(*TheContext, Name);
+    if (!SliceTy) {
+        SliceTy = llvm::StructType::create(*TheContext, {Builder->getPtrTy(), Builder->getInt64Ty()}, Name);
+        AggregateTypes.emplace(SliceTy, Type::getSlice(element));
+    }
+    return SliceTy;
+}
+
+bool CodeGen::isFatPointer(llvm::Type* type) {
+    return type == StrTy || getTypeOf(type).isSlice();
+}
+
+llvm::StructType* CodeGen::getSoAColumnsType(const StructInfo& info, uint64_t length) {
+    std::string Name = std::string(info.Decl->getName()) + ".soa." + std::to_string(length);
+    if (llvm::StructType* Columns = llvm::StructType::getTypeByName(*TheContext, Name)) {
+        return Columns;
+    }
+    std::vector<llvm::Type*> ColumnTypes;
+    for (unsigned Index : info.FieldIndices) {
+        ColumnTypes.push_back(llvm::ArrayType::get(info.Ty->getElementType(Index), length));
+    }
+    return llvm::StructType::create(*TheContext, ColumnTypes, Name);
+}
+
+Type CodeGen::getTypeOf(llvm::Type* type) {
+    auto aggregate = AggregateTypes.find(type);
+    if (aggregate != AggregateTypes.end()) {
+        return aggregate->second;
+    }
+    if (type == StrTy) {
+        return TypeKind::Str;
+    }
+    if (type->isIntegerTy(64)) {
+        return TypeKind::I64;
+    }
+    if (type->isIntegerTy(1)) {
+        return TypeKind::Bool;
+    }
+    return TypeKind::Void;
+}
+
+llvm::FunctionType* CodeGen::getFunctionType(const FunctionDecl& decl) {
+    // main returns the exit status to the C runtime.
+    llvm::Type* returnType = decl.getName() == "main" ? Builder->getInt32Ty()
+                                                      : getLLVMType(decl.getReturnType());
+    if (!returnType) {
+        return nullptr;
+    }
+    // An async function returns the handle of the coroutine it started; its
+    // result is left in the coroutine's promise.
+    if (decl.isAsync() && decl.getName() != "main") {
+        returnType = Builder->getPtrTy();
+    }
+
+    std::vector<llvm::Type*> ParamTypes;
+    for (const Param& param : decl.getParams()) {
+        llvm::Type* ParamTy = getLLVMType(param.Ty);
+        if (!ParamTy) {
+            return nullptr;
+        }
+        if (isFatPointer(ParamTy)) {
+            ParamTypes.push_back(Builder->getPtrTy());
+            ParamTypes.push_back(Builder->getInt64Ty());
+        } else {
+            ParamTypes.push_back(ParamTy);
+        }
+    }
+    return llvm::FunctionType::get(returnType, ParamTypes, false);
+}
+
+void CodeGen::appendLoweredArg(llvm::Value* value, std::vector<llvm::Value*>& args) {
+    if (isFatPointer(value->getType())) {
+        args.push_back(Builder->CreateExtractValue(value, 0));
+        args.push_back(Builder->CreateExtractValue(value, 1));
+    } else {
+        args.push_back(value);
+    }
+}
+
+llvm::Function* CodeGen::emitCallee(CallExpr& call, std::vector<llvm::Value*>& args) {
+    std::vector<llvm::Value*> Values;
+    for (const auto& arg : call.getArgs()) {
+        arg->accept(*this);
+        if (!V) {
+            return nullptr;
+        }
+        Values.push_back(V);
+    }
 
-    if (!InitializerValue) {
-        std::cerr << "CodeGen Error: VarDecl initializer is null." << std::endl;
+    llvm::Function* Callee = nullptr;
+    auto generic = GenericFunctions.find(call.getCalleeName());
+    if (generic != GenericFunctions.end()) {
+        Callee = instantiateFor(*generic->second, call, Values);
+    } else {
+        Callee = lookupFunction(call.getCalleeName());
+        if (!Callee) {
+            std::cerr << "CodeGen Error: Unknown function referenced: " << call.getCalleeName() << std::endl;
+        }
+    }
+    if (!Callee) {
+        return nullptr;
+    }
+
+    for (llvm::Value* value : Values) {
+        appendLoweredArg(value, args);
+    }
+    llvm::FunctionType* FT = Callee->getFunctionType();
+    bool matches = args.size() == FT->getNumParams();
+    for (size_t i = 0; matches && i < args.size(); ++i) {
+        matches = args[i]->getType() == FT->getParamType(i);
+    }
+    if (!matches) {
+        std::cerr << "CodeGen Error: The arguments of the call to '" << call.getCalleeName()
+                  << "' do not match its parameters." << std::endl;
+        return nullptr;
+    }
+    return Callee;
+}
+
+llvm::Function* CodeGen::instantiateFor(FunctionDecl& decl, CallExpr& call,
+                                        const std::vector<llvm::Value*>& values) {
+    const auto& Params = decl.getParams();
+    if (values.size() != Params.size()) {
+        std::cerr << "CodeGen Error: The arguments of the call to '" << call.getCalleeName()
+                  << "' do not match its parameters." << std::endl;
+        return nullptr;
+    }
+
+    // Each type parameter takes the type of the first argument passed for
+    // a parameter declared with it; the other such arguments must agree.
+    const auto& TypeParams = decl.getTypeParams();
+    std::vector<Type> TypeArgs(TypeParams.size());
+    for (size_t i = 0; i < Params.size(); ++i) {
+        if (!Params[i].Ty.isParam()) {
+            continue;
+        }
+        size_t Index = 0;
+        while (TypeParams[Index].lexeme != Params[i].Ty.getIdentifier()) {
+            ++Index;
+        }
+        Type ArgTy = getTypeOf(values[i]->getType());
+        if (TypeArgs[Index].isVoid()) {
+            TypeArgs[Index] = ArgTy;
+        } else if (TypeArgs[Index] != ArgTy) {
+            std::cerr << "CodeGen Error: '" << TypeParams[Index].lexeme << "' of '" << decl.getName()
+                      << "' cannot be both '" << TypeArgs[Index].getName() << "' and '"
+                      << ArgTy.getName() << "' in the same call." << std::endl;
+            return nullptr;
+        }
+    }
+    for (size_t i = 0; i < TypeParams.size(); ++i) {
+        if (TypeArgs[i].isVoid()) {
+            std::cerr << "CodeGen Error: Cannot infer '" << TypeParams[i].lexeme << "' of '"
+                      << decl.getName() << "' from the call's arguments." << std::endl;
+            return nullptr;
+        }
+    }
+    return instantiate(decl, TypeArgs);
+}
+
+llvm::Function* CodeGen::instantiate(FunctionDecl& decl, const std::vector<Type>& typeArgs) {
+    auto Key = std::make_pair(static_cast<const FunctionDecl*>(&decl), typeArgs);
+    auto cached = Specializations.find(Key);
+    if (cached != Specializations.end()) {
+        return cached->second;
+    }
+
+    // The instantiation is named after its type arguments, e.g. 'max<i64>'.
+    std::string Name(decl.getName());
+    for (size_t i = 0; i < typeArgs.size(); ++i) {
+        Name += (i == 0 ? "<" : ", ") + typeArgs[i].getName();
+    }
+    Name += ">";
+
+    auto OuterSubstitution = std::move(TypeSubstitution);
+    TypeSubstitution = bindTypeArgs(decl, typeArgs);
+    llvm::FunctionType* FT = getFunctionType(decl);
+    llvm::Type* ResultTy = decl.isAsync() ? getLLVMType(decl.getReturnType()) : nullptr;
+    TypeSubstitution = std::move(OuterSubstitution);
+    if (!FT) {
+        return nullptr;
+    }
+
+    // Every module calling an instantiation has its own copy. They are all
+    // the same, so the linker keeps one and the optimizer may inline any.
+    llvm::Function* F = llvm::Function::Create(FT, llvm::Function::LinkOnceODRLinkage, Name,
+                                               TheModule.get());
+    if (!getTargetTriple().isOSBinFormatMachO()) {
+        F->setComdat(TheModule->getOrInsertComdat(Name));
+    }
+    applyFunctionAttrs(decl, F);
+    if (ResultTy) {
+        AsyncFunctions[F] = getPromiseType(ResultTy);
+    }
+
+    Specializations.emplace(std::move(Key), F);
+    InstantiationQueue.push_back({&decl, typeArgs, F});
+    return F;
+}
+
+std::map<std::string_view, Type> CodeGen::bindTypeArgs(const FunctionDecl& decl,
+                                                       const std::vector<Type>& typeArgs) {
+    std::map<std::string_view, Type> Substitution;
+    for (size_t i = 0; i < typeArgs.size(); ++i) {
+        Substitution[decl.getTypeParams()[i].lexeme] = typeArgs[i];
+    }
+    return Substitution;
+}
+
+bool CodeGen::hasTargetClones(const FunctionDecl& decl) const {
+    llvm::Triple triple(TheModule->getTargetTriple());
+    return !decl.getTargetClones().empty() && !decl.isImported() && !decl.isAsync() &&
+           decl.getName() != "main" && triple.getArch() == llvm::Triple::x86_64 &&
+           triple.isOSBinFormatELF();
+}
+
+// Compiles 'F' for the base x86-64 instruction set plus 'features', whatever
+// '--march' says: code that runs before the CPU has been checked, or on a CPU
+// that failed the check, must not use anything else. '--march' only tunes it.
+static void setBaseX86Target(llvm::Function* F, const std::string& features,
+                             const std::string& tuneCPU) {
+    F->addFnAttr("target-cpu", "x86-64");
+    F->addFnAttr("target-features", features);
+    if (!tuneCPU.empty()) {
+        F->addFnAttr("tune-cpu", tuneCPU);
+    }
+}
+
+void CodeGen::declareTargetClones(FunctionDecl& decl, llvm::FunctionType* FT) {
+    std::string Name(decl.getName());
+    llvm::Function* Default = nullptr;
+    std::vector<std::pair<unsigned, llvm::Function*>> Clones; // By TargetClones index.
+
+    // Check every name first, so that an error leaves no clones behind.
+    std::vector<unsigned> Indices; // Into TargetClones; its size for "default".
+    bool HasDefault = false;
+    for (std::string_view isa : decl.getTargetClones()) {
+        unsigned Index = 0;
+        while (Index < std::size(TargetClones) && isa != TargetClones[Index].Name) {
+            ++Index;
+        }
+        if (Index == std::size(TargetClones) && isa != "default") {
+            std::cerr << "CodeGen Error: Unknown target clone '" << isa << "' on '" << Name
+                      << "'; expected avx512f, avx2, fma, avx, sse4.2 or default." << std::endl;
+            return;
+        }
+        HasDefault |= isa == "default";
+        Indices.push_back(Index);
+    }
+    if (!HasDefault) {
+        std::cerr << "CodeGen Error: '@target_clones' on '" << Name
+                  << "' needs a \"default\" clone for CPUs without any of the others." << std::endl;
+        return;
+    }
+
+    for (size_t i = 0; i < Indices.size(); ++i) {
+        unsigned Index = Indices[i];
+        std::string_view isa = decl.getTargetClones()[i];
+        llvm::Function* Clone = llvm::Function::Create(FT, llvm::Function::InternalLinkage,
+                                                       Name + "." + std::string(isa), TheModule.get());
+        applyFunctionAttrs(decl, Clone);
+        setBaseX86Target(Clone, Index < std::size(TargetClones) ? TargetClones[Index].Features : "",
+                         TargetCPU);
+        if (Index < std::size(TargetClones)) {
+            Clones.emplace_back(Index, Clone);
+        } else {
+            Default = Clone;
+        }
+    }
+
+    // The resolver runs once, when the dynamic loader binds the ifunc, and
+    // returns the most preferred clone the CPU supports.
+    llvm::FunctionType* ResolverTy = llvm::FunctionType::get(Builder->getPtrTy(), false);
+    llvm::Function* Resolver = llvm::Function::Create(ResolverTy, llvm::Function::InternalLinkage,
+                                                      Name + ".resolver", TheModule.get());
+    setBaseX86Target(Resolver, "", TargetCPU);
+    llvm::IRBuilder<> ResolverBuilder(llvm::BasicBlock::Create(*TheContext, "entry", Resolver));
+    llvm::Value* Mask = ResolverBuilder.CreateCall(getCPUFeaturesFunction(), {}, "features");
+    std::sort(Clones.begin(), Clones.end(),
+              [](const auto& a, const auto& b) { return a.first > b.first; });
+    llvm::Value* Selected = Default;
+    for (const auto& [index, clone] : Clones) {
+        llvm::Value* Bit = ResolverBuilder.getInt32(1u << index);
+        llvm::Value* Supported = ResolverBuilder.CreateICmpNE(ResolverBuilder.CreateAnd(Mask, Bit),
+                                                              ResolverBuilder.getInt32(0));
+        Selected = ResolverBuilder.CreateSelect(Supported, clone, Selected);
+    }
+    ResolverBuilder.CreateRet(Selected);
+
+    llvm::GlobalIFunc* IFunc = llvm::GlobalIFunc::create(FT, 0, llvm::Function::ExternalLinkage,
+                                                         Name, Resolver, TheModule.get());
+    CloneDispatchers[Default] = IFunc;
+}
+
+void CodeGen::emitTargetClones(FunctionDecl& decl) {
+    // Without an ifunc, declare() rejected the clones and said why.
+    if (!TheModule->getNamedIFunc(decl.getName())) {
         return;
     }
+    for (std::string_view isa : decl.getTargetClones()) {
+        std::string CloneName = std::string(decl.getName()) + "." + std::string(isa);
+        emitFunctionBody(decl, TheModule->getFunction(CloneName));
+    }
+}
+
+llvm::Function* CodeGen::getCPUFeaturesFunction() {
+    if (llvm::Function* F = TheModule->getFunction("__sa_cpu_features")) {
+        return F;
+    }
+
+    llvm::Function* F = llvm::Function::Create(llvm::FunctionType::get(Builder->getInt32Ty(), false),
+                                               llvm::Function::InternalLinkage,
+                                               "__sa_cpu_features", TheModule.get());
+    setBaseX86Target(F, "", TargetCPU);
+    llvm::BasicBlock* Entry = llvm::BasicBlock::Create(*TheContext, "entry", F);
+    llvm::BasicBlock* ReadXCR0 = llvm::BasicBlock::Create(*TheContext, "xgetbv", F);
+    llvm::BasicBlock* Done = llvm::BasicBlock::Create(*TheContext, "done", F);
+    llvm::IRBuilder<> B(Entry);
+    llvm::Type* I32 = B.getInt32Ty();
+
+    // cpuid(leaf, subleaf) -> {eax, ebx, ecx, edx}
+    llvm::InlineAsm* CPUID = llvm::InlineAsm::get(
+        llvm::FunctionType::get(llvm::StructType::get(I32, I32, I32, I32), {I32, I32}, false),
+        "cpuid", "={ax},={bx},={cx},={dx},0,2,~{dirflag},~{fpsr},~{flags}", false);
+    auto cpuid = [&](unsigned leaf, unsigned reg) {
+        return B.CreateExtractValue(B.CreateCall(CPUID, {B.getInt32(leaf), B.getInt32(0)}), reg);
+    };
+    auto bit = [&](llvm::Value* value, unsigned index) {
+        return B.CreateICmpNE(B.CreateAnd(value, B.getInt32(1u << index)), B.getInt32(0));
+    };
+
+    llvm::Value* MaxLeaf = cpuid(0, 0);
+    llvm::Value* Leaf1ECX = cpuid(1, 2);
+    // Leaf 7 reads as the highest supported leaf on CPUs that lack it.
+    llvm::Value* Leaf7EBX = B.CreateSelect(B.CreateICmpUGE(MaxLeaf, B.getInt32(7)), cpuid(7, 1),
+                                           B.getInt32(0));
+
+    // The AVX registers are only usable if the OS saves them on context
+    // switches, which XCR0 tells. xgetbv itself faults without OSXSAVE.
+    B.CreateCondBr(bit(Leaf1ECX, 27), ReadXCR0, Done);
+    B.SetInsertPoint(ReadXCR0);
+    llvm::InlineAsm* XGETBV = llvm::InlineAsm::get(
+        llvm::FunctionType::get(llvm::StructType::get(I32, I32), {I32}, false),
+        "xgetbv", "={ax},={dx},{cx},~{dirflag},~{fpsr},~{flags}", false);
+    llvm::Value* XCR0Low = B.CreateExtractValue(B.CreateCall(XGETBV, {B.getInt32(0)}), 0);
+    B.CreateBr(Done);
+
+    B.SetInsertPoint(Done);
+    llvm::PHINode* XCR0 = B.CreatePHI(I32, 2, "xcr0");
+    XCR0->addIncoming(B.getInt32(0), Entry);
+    XCR0->addIncoming(XCR0Low, ReadXCR0);
+    auto hasAll = [&](llvm::Value* value, unsigned bits) {
+        return B.CreateICmpEQ(B.CreateAnd(value, B.getInt32(bits)), B.getInt32(bits));
+    };
+    llvm::Value* YMM = hasAll(XCR0, 0x6);   // SSE and AVX state.
+    llvm::Value* ZMM = hasAll(XCR0, 0xE6);  // ... and the AVX-512 state.
+
+    llvm::Value* AVX = B.CreateAnd(bit(Leaf1ECX, 28), YMM);
+    llvm::Value* Supported[] = {
+        B.CreateAnd(B.CreateAnd(bit(Leaf7EBX, 16), ZMM), AVX), // avx512f
+        B.CreateAnd(bit(Leaf7EBX, 5), AVX),                    // avx2
+        B.CreateAnd(bit(Leaf1ECX, 12), AVX),                   // fma
+        AVX,                                                   // avx
+        bit(Leaf1ECX, 20),                                     // sse4.2
+    };
+    static_assert(std::size(Supported) == std::size(TargetClones));
+
+    llvm::Value* Mask = B.getInt32(0);
+    for (unsigned i = 0; i < std::size(Supported); ++i) {
+        Mask = B.CreateOr(Mask, B.CreateShl(B.CreateZExt(Supported[i], I32), i));
+    }
+    B.CreateRet(Mask);
+    return F;
+}
+
+llvm::Function* CodeGen::lookupFunction(std::string_view name) {
+    if (llvm::Function* F = TheModule->getFunction(name)) {
+        return F;
+    }
+    if (TheModule->getNamedIFunc(name)) {
+        return TheModule->getFunction(std::string(name) + ".default");
+    }
+    for (const auto& [alias, runtimeName] : RuntimeAliases) {
+        if (name == alias) {
+            return TheModule->getFunction(runtimeName);
+        }
+    }
+    return nullptr;
+}
+
+llvm::FunctionCallee CodeGen::getCallee(llvm::Function* F) {
+    auto it = CloneDispatchers.find(F);
+    if (it == CloneDispatchers.end()) {
+        return F;
+    }
+    return llvm::FunctionCallee(F->getFunctionType(), it->second);
+}
+
+void CodeGen::applyFunctionAttrs(const FunctionDecl& decl, llvm::Function* F) {
+    if (!TargetCPU.empty()) {
+        F->addFnAttr("target-cpu", TargetCPU);
+    }
+    if (!TargetFeatures.empty()) {
+        F->addFnAttr("target-features", TargetFeatures);
+    }
+
+    if (decl.hasAttr(FA_Inline)) {
+        F->addFnAttr(llvm::Attribute::AlwaysInline);
+    }
+    if (decl.hasAttr(FA_NoInline)) {
+        F->addFnAttr(llvm::Attribute::NoInline);
+    }
+
+    // Hot and cold code go into the '.text.hot.' and '.text.unlikely.'
+    // sections, which the standard ELF linker scripts group together. Other
+    // object formats only get the attribute.
+    bool isELF = llvm::Triple(TheModule->getTargetTriple()).isOSBinFormatELF();
+    if (decl.hasAttr(FA_Hot)) {
+        F->addFnAttr(llvm::Attribute::Hot);
+        if (isELF) {
+            F->setSection(".text.hot." + std::string(decl.getName()));
+        }
+    }
+    if (decl.hasAttr(FA_Cold)) {
+        F->addFnAttr(llvm::Attribute::Cold);
+        F->addFnAttr(llvm::Attribute::OptimizeForSize);
+        if (isELF) {
+            F->setSection(".text.unlikely." + std::string(decl.getName()));
+        }
+    }
+
+    // A pure function writes no memory the caller can see and does not
+    // unwind, so repeated calls with nothing written in between can be
+    // merged. It may read through a slice it was passed, and it may never
+    // return (it can loop or fail a bounds check), so a call is not deleted
+    // just because its result is unused.
+    if (decl.hasAttr(FA_Pure)) {
+        F->setOnlyReadsMemory();
+        F->setDoesNotThrow();
+    }
+}
+
+void CodeGen::visit(VarDecl& decl) {
+    llvm::Type* DeclaredTy = nullptr;
+    if (!decl.getDeclaredType().isVoid()) {
+        DeclaredTy = getLLVMType(decl.getDeclaredType());
+        if (!DeclaredTy) {
+            return;
+        }
+    }
+
+    llvm::Value* InitializerValue = nullptr;
+    if (decl.getInitializer()) {
+        decl.getInitializer()->accept(*this);
+        InitializerValue = V;
+        if (!InitializerValue) {
+            std::cerr << "CodeGen Error: VarDecl initializer is null." << std::endl;
+            return;
+        }
+        if (DeclaredTy && InitializerValue->getType() != DeclaredTy) {
+            std::cerr << "CodeGen Error: '" << decl.getName() << "' is declared as '"
+                      << getTypeOf(DeclaredTy).getName() << "' but initialized with a '"
+                      << getTypeOf(InitializerValue->getType()).getName() << "'." << std::endl;
+            return;
+        }
+    }
 
-    llvm::AllocaInst* Alloca = Builder->CreateAlloca(InitializerValue->getType(),
-                                                    nullptr, decl.getName());
-    Builder->CreateStore(InitializerValue, Alloca);
+    llvm::Type* Ty = DeclaredTy ? DeclaredTy : InitializerValue->getType();
+    llvm::AllocaInst* Alloca = createEntryBlockAlloca(Ty, decl.getName());
+    if (InitializerValue) {
+        Builder->CreateStore(InitializerValue, Alloca);
+    } else if (Ty->isAggregateType()) {
+        // Zero large arrays with a memset rather than a store of a huge
+        // constant.
+        uint64_t Size = TheModule->getDataLayout().getTypeAllocSize(Ty);
+        Builder->CreateMemSet(Alloca, Builder->getInt8(0), Size, Alloca->getAlign());
+    } else {
+        Builder->CreateStore(llvm::Constant::getNullValue(Ty), Alloca);
+    }
     NamedValues[decl.getName()] = Alloca;
 }
 
+void CodeGen::visit(StructDecl& decl) {
+    std::string_view Name = decl.getName();
+    if (Structs.count(Name)) {
+        std::cerr << "CodeGen Error: Struct '" << Name << "' is declared more than once." << std::endl;
+        return;
+    }
+
+    const auto& Fields = decl.getFields();
+    std::vector<llvm::Type*> FieldTypes;
+    for (const Field& field : Fields) {
+        llvm::Type* FieldTy = getLLVMType(field.Ty);
+        if (!FieldTy) {
+            return;
+        }
+        FieldTypes.push_back(FieldTy);
+    }
+
+    // Laying the fields out from the most to the least aligned leaves no
+    // padding between them, only (possibly) after the last. A packed struct
+    // has no padding anyway, so it keeps the declared order.
+    const llvm::DataLayout& DL = TheModule->getDataLayout();
+    std::vector<unsigned> Order(Fields.size());
+    std::iota(Order.begin(), Order.end(), 0);
+    if (!decl.hasAttr(SA_Packed)) {
+        std::stable_sort(Order.begin(), Order.end(), [&](unsigned a, unsigned b) {
+            return DL.getABITypeAlign(FieldTypes[a]) > DL.getABITypeAlign(FieldTypes[b]);
+        });
+    }
+
+    // LLVM struct types have no alignment of their own. A leading
+    // zero-length array of an N-byte vector, which is N-byte aligned, gives
+    // the struct that alignment without adding to its size, and rounds the
+    // size up to a multiple of N.
+    std::vector<llvm::Type*> Elements;
+    if (decl.getAlign() != 0) {
+        llvm::Type* Marker = llvm::FixedVectorType::get(Builder->getInt8Ty(), decl.getAlign());
+        Elements.push_back(llvm::ArrayType::get(Marker, 0));
+    }
+    std::vector<unsigned> FieldIndices(Fields.size());
+    for (unsigned Index : Order) {
+        FieldIndices[Index] = Elements.size();
+        Elements.push_back(FieldTypes[Index]);
+    }
+
+    llvm::StructType* Ty = llvm::StructType::create(*TheContext, Elements, Name,
+                                                    decl.hasAttr(SA_Packed));
+    Structs[Name] = {&decl, Ty, std::move(FieldIndices)};
+    AggregateTypes.emplace(Ty, Type::getStruct(Name));
+}
+
+void CodeGen::visit(ImportDecl& decl) {
+    if (!decl.getModule()) {
+        std::cerr << "CodeGen Error: Unresolved import '" << decl.getName() << "'." << std::endl;
+        return;
+    }
+    emitImportedModule(*decl.getModule());
+}
+
+void CodeGen::emitImportedModule(ModuleFile& module) {
+    if (!EmittedModules.insert(&module).second) {
+        return;
+    }
+    for (const auto& dep : module.getDependencies()) {
+        emitImportedModule(*dep);
+    }
+    // The bodies kept for inlining may call any export of the module,
+    // including ones that come after them.
+    for (const auto& fn : module.getFunctions()) {
+        declare(*fn);
+    }
+    for (const auto& fn : module.getFunctions()) {
+        fn->accept(*this);
+    }
+}
+
 void CodeGen::visit(DeclStmt& stmt) {
     stmt.getDecl()->accept(*this);
 }
 
 void CodeGen::visit(ExprStmt& stmt) {
+    DiscardedAwait = dynamic_cast<const AwaitExpr*>(stmt.getExpr());
     stmt.getExpr()->accept(*this);
+    DiscardedAwait = nullptr;
 }
 
-void CodeGen::visit(StringLiteralExpr& expr) {
-    V = Builder->CreateGlobalString(expr.getValue());
-}
-
-void CodeGen::visit(VariableExpr& expr) {
-    llvm::Value* VarAlloca = NamedValues[expr.getName()];
-    if (!VarAlloca) {
-        std::cerr << "CodeGen Error: Unknown variable name '" << expr.getName() << "'." << std::endl;
-        V = nullptr;
+void CodeGen::visit(SpawnStmt& stmt) {
+    if (CurrentFunction->hasAttr(FA_Pure)) {
+        std::cerr << "CodeGen Error: Pure function '" << CurrentFunction->getName()
+                  << "' cannot spawn tasks." << std::endl;
         return;
     }
-    V = Builder->CreateLoad(static_cast<llvm::AllocaInst*>(VarAlloca)->getAllocatedType(),
-                            VarAlloca, expr.getName());
-}
 
-void CodeGen::visit(CallExpr& expr) {
-    llvm::Function* CalleeF = TheModule->getFunction(expr.getCalleeName());
+    // Evaluate the arguments here, in the spawning function, and pack them
+    // into an environment that the runtime copies into the task.
+    std::vector<llvm::Value*> ArgsV;
+    llvm::Function* CalleeF = emitCallee(*stmt.getCall(), ArgsV);
     if (!CalleeF) {
-        std::cerr << "CodeGen Error: Unknown function referenced: " << expr.getCalleeName() << std::endl;
-        V = nullptr;
         return;
     }
 
-    std::vector<llvm::Value*> ArgsV;
-    for (const auto& arg : expr.getArgs()) {
-        arg->accept(*this);
-        ArgsV.push_back(V);
+    // An async function runs on the event loop instead of another thread.
+    // Started here, it goes on by itself from where it first suspends.
+    auto async = AsyncFunctions.find(CalleeF);
+    if (async != AsyncFunctions.end()) {
+        if (!CurrentCoroutine) {
+            std::cerr << "CodeGen Error: Async function '" << stmt.getCall()->getCalleeName()
+                      << "' can only be spawned from an async function." << std::endl;
+            return;
+        }
+        emitDetach(Builder->CreateCall(CalleeF, ArgsV, "task"), async->second);
+        return;
     }
 
-    // Only give the call a name if it returns a non-void value
-    if (CalleeF->getReturnType()->isVoidTy()) {
-        V = Builder->CreateCall(CalleeF, ArgsV);
-    } else {
-        V = Builder->CreateCall(CalleeF, ArgsV, "calltmp");
+    llvm::Value* Env = llvm::ConstantPointerNull::get(Builder->getPtrTy());
+    uint64_t EnvSize = 0;
+    if (!ArgsV.empty()) {
+        llvm::StructType* EnvTy = llvm::StructType::get(*TheContext, CalleeF->getFunctionType()->params());
+        Env = createEntryBlockAlloca(EnvTy, "spawn.env");
+
+        for (size_t i = 0; i < ArgsV.size(); ++i) {
+            Builder->CreateStore(ArgsV[i], Builder->CreateStructGEP(EnvTy, Env, i));
+        }
+        EnvSize = TheModule->getDataLayout().getTypeAllocSize(EnvTy);
+    }
+
+    Builder->CreateCall(TheModule->getFunction("sa_spawn"),
+                        {TaskGroup, getSpawnThunk(CalleeF), Env,
+                         Builder->getInt64(EnvSize)});
+}
+
+void CodeGen::visit(JoinStmt& stmt) {
+    // The function spawns nothing, so there is nothing to wait for.
+    if (!TaskGroup) {
+        return;
+    }
+    Builder->CreateCall(TheModule->getFunction("sa_join"), {TaskGroup});
+}
+
+void CodeGen::visit(ReturnStmt& stmt) {
+    // 'main' returns nothing in the source; its exit status is added below.
+    Type Expected = CurrentFunction->getName() == "main"
+        ? Type() : getTypeOf(getLLVMType(CurrentFunction->getReturnType()));
+    llvm::Value* Value = nullptr;
+    if (stmt.getValue()) {
+        stmt.getValue()->accept(*this);
+        if (!V) {
+            return;
+        }
+        Value = V;
+    }
+
+    Type Actual = Value ? getTypeOf(Value->getType()) : Type();
+    if (Actual != Expected) {
+        std::cerr << "CodeGen Error: '" << CurrentFunction->getName() << "' returns '"
+                  << Expected.getName() << "', not '" << Actual.getName() << "'." << std::endl;
+        return;
+    }
+    emitReturn(Value);
+
+    // Anything after the 'return' is unreachable, but still needs a block.
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    Builder->SetInsertPoint(llvm::BasicBlock::Create(*TheContext, "after.return", F));
+}
+
+void CodeGen::emitReturn(llvm::Value* value) {
+    // Tasks may refer to this frame, so they must finish before it is gone.
+    if (TaskGroup) {
+        Builder->CreateCall(TheModule->getFunction("sa_join"), {TaskGroup});
+    }
+    for (auto it = ActiveRegions.rbegin(); it != ActiveRegions.rend(); ++it) {
+        Builder->CreateCall(TheModule->getFunction("sa_region_exit"), {*it});
+    }
+
+    // A coroutine leaves its result for whoever awaits it and finishes at
+    // its final suspension point.
+    if (CurrentCoroutine) {
+        if (value) {
+            Builder->CreateStore(value, Builder->CreateStructGEP(CurrentCoroutine->PromiseTy,
+                                                                 CurrentCoroutine->Promise, 2));
+        }
+        Builder->CreateBr(CurrentCoroutine->Final);
+        return;
+    }
+
+    if (CurrentFunction->getName() == "main") {
+        Builder->CreateRet(Builder->getInt32(0));
+    } else if (value) {
+        Builder->CreateRet(value);
+    } else {
+        Builder->CreateRetVoid();
+    }
+}
+
+void CodeGen::visit(IfStmt& stmt) {
+    stmt.getCond()->accept(*this);
+    if (!V) {
+        return;
+    }
+    if (!V->getType()->isIntegerTy(1)) {
+        std::cerr << "CodeGen Error: The condition of an 'if' must be a 'bool', not '"
+                  << getTypeOf(V->getType()).getName() << "'." << std::endl;
+        return;
+    }
+
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* ThenBB = llvm::BasicBlock::Create(*TheContext, "if.then", F);
+    llvm::BasicBlock* ElseBB = llvm::BasicBlock::Create(*TheContext, "if.else");
+    llvm::BasicBlock* EndBB = llvm::BasicBlock::Create(*TheContext, "if.end");
+    bool HasElse = !stmt.getElse().empty();
+    Builder->CreateCondBr(V, ThenBB, HasElse ? ElseBB : EndBB);
+
+    Builder->SetInsertPoint(ThenBB);
+    emitBlock(stmt.getThen());
+    emitBranch(EndBB);
+
+    if (HasElse) {
+        ElseBB->insertInto(F);
+        Builder->SetInsertPoint(ElseBB);
+        emitBlock(stmt.getElse());
+        emitBranch(EndBB);
+    } else {
+        delete ElseBB;
+    }
+
+    EndBB->insertInto(F);
+    Builder->SetInsertPoint(EndBB);
+}
+
+void CodeGen::emitBranch(llvm::BasicBlock* dest) {
+    // A block that ended in a 'return' continues in a block nothing jumps
+    // to, which must not make 'dest' look reachable.
+    llvm::BasicBlock* BB = Builder->GetInsertBlock();
+    if (BB->getTerminator()) {
+        return;
+    }
+    if (llvm::pred_empty(BB)) {
+        Builder->CreateUnreachable();
+    } else {
+        Builder->CreateBr(dest);
+    }
+}
+
+void CodeGen::visit(WhileStmt& stmt) {
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* CondBB = llvm::BasicBlock::Create(*TheContext, "while.cond", F);
+    llvm::BasicBlock* BodyBB = llvm::BasicBlock::Create(*TheContext, "while.body");
+    llvm::BasicBlock* EndBB = llvm::BasicBlock::Create(*TheContext, "while.end");
+    Builder->CreateBr(CondBB);
+
+    Builder->SetInsertPoint(CondBB);
+    stmt.getCond()->accept(*this);
+    if (V && !V->getType()->isIntegerTy(1)) {
+        std::cerr << "CodeGen Error: The condition of a 'while' must be a 'bool', not '"
+                  << getTypeOf(V->getType()).getName() << "'." << std::endl;
+        V = nullptr;
+    }
+    if (!V) {
+        Builder->CreateBr(EndBB);
+        delete BodyBB;
+        EndBB->insertInto(F);
+        Builder->SetInsertPoint(EndBB);
+        return;
+    }
+    Builder->CreateCondBr(V, BodyBB, EndBB);
+
+    BodyBB->insertInto(F);
+    Builder->SetInsertPoint(BodyBB);
+    emitBlock(stmt.getBody());
+    emitBranch(CondBB);
+
+    EndBB->insertInto(F);
+    Builder->SetInsertPoint(EndBB);
+}
+
+void CodeGen::visit(ForStmt& stmt) {
+    llvm::Value* Bounds[2];
+    Expr* BoundExprs[2] = {stmt.getLo(), stmt.getHi()};
+    for (int i = 0; i < 2; ++i) {
+        BoundExprs[i]->accept(*this);
+        if (!V) {
+            return;
+        }
+        if (!V->getType()->isIntegerTy(64)) {
+            std::cerr << "CodeGen Error: The range of a 'for' loop must be of 'i64's, not '"
+                      << getTypeOf(V->getType()).getName() << "'." << std::endl;
+            return;
+        }
+        Bounds[i] = V;
+    }
+    llvm::Value* Lo = Bounds[0];
+    llvm::Value* Hi = Bounds[1];
+
+    // The accesses the front end hoisted out of the loop are checked here,
+    // all at once: a non-empty range must lie within the array. If it does
+    // not, the loop fails before its first iteration rather than at the
+    // first index out of range.
+    if (BoundsChecks != BoundsCheckMode::Off && !stmt.getHoistedChecks().empty()) {
+        llvm::Value* NonEmpty = Builder->CreateICmpSLT(Lo, Hi);
+        llvm::Value* LoNegative = Builder->CreateICmpSLT(Lo, Builder->getInt64(0));
+        llvm::Value* Reported = Builder->CreateSelect(
+            LoNegative, Lo, Builder->CreateSub(Hi, Builder->getInt64(1)));
+        for (std::string_view Name : stmt.getHoistedChecks()) {
+            auto it = NamedValues.find(Name);
+            if (it == NamedValues.end()) {
+                continue; // The access reports the unknown name.
+            }
+            auto* Alloca = static_cast<llvm::AllocaInst*>(it->second);
+            Place P{Alloca, getTypeOf(Alloca->getAllocatedType())};
+            if (!P.Ty.isArray() && !P.Ty.isSlice()) {
+                continue;
+            }
+            llvm::Value* Length = emitLength(P);
+            llvm::Value* InRange = Builder->CreateAnd(Builder->CreateNot(LoNegative),
+                                                      Builder->CreateICmpSLE(Hi, Length));
+            emitBoundsCheck(Builder->CreateOr(Builder->CreateNot(NonEmpty), InRange), Reported, Length);
+        }
+    }
+
+    llvm::AllocaInst* Var = createEntryBlockAlloca(Builder->getInt64Ty(), stmt.getVar());
+    Builder->CreateStore(Lo, Var);
+
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* CondBB = llvm::BasicBlock::Create(*TheContext, "for.cond", F);
+    llvm::BasicBlock* BodyBB = llvm::BasicBlock::Create(*TheContext, "for.body", F);
+    llvm::BasicBlock* IncBB = llvm::BasicBlock::Create(*TheContext, "for.inc");
+    llvm::BasicBlock* EndBB = llvm::BasicBlock::Create(*TheContext, "for.end");
+    Builder->CreateBr(CondBB);
+
+    Builder->SetInsertPoint(CondBB);
+    llvm::Value* Index = Builder->CreateLoad(Builder->getInt64Ty(), Var, stmt.getVar());
+    Builder->CreateCondBr(Builder->CreateICmpSLT(Index, Hi), BodyBB, EndBB);
+
+    // The loop variable is only in scope in the body.
+    Builder->SetInsertPoint(BodyBB);
+    auto OuterNames = NamedValues;
+    NamedValues[stmt.getVar()] = Var;
+    emitBlock(stmt.getBody());
+    NamedValues = std::move(OuterNames);
+    emitBranch(IncBB);
+
+    // The index stays below 'hi', so it cannot overflow.
+    IncBB->insertInto(F);
+    Builder->SetInsertPoint(IncBB);
+    Index = Builder->CreateLoad(Builder->getInt64Ty(), Var, stmt.getVar());
+    Builder->CreateStore(Builder->CreateNSWAdd(Index, Builder->getInt64(1)), Var);
+    Builder->CreateBr(CondBB);
+
+    EndBB->insertInto(F);
+    Builder->SetInsertPoint(EndBB);
+}
+
+void CodeGen::emitBlock(const std::vector<std::unique_ptr<Stmt>>& stmts) {
+    auto OuterNames = NamedValues;
+    for (const auto& stmt : stmts) {
+        stmt->accept(*this);
+    }
+    NamedValues = std::move(OuterNames);
+}
+
+bool CodeGen::spawnsTasks(const std::vector<std::unique_ptr<Stmt>>& stmts) {
+    for (const auto& stmt : stmts) {
+        if (auto* spawn = dynamic_cast<SpawnStmt*>(stmt.get())) {
+            // Looked up like emitCallee() does. Unknown callees count; the
+            // spawn reports them.
+            std::string_view Name = spawn->getCall()->getCalleeName();
+            auto generic = GenericFunctions.find(Name);
+            llvm::Function* F = lookupFunction(Name);
+            bool async = generic != GenericFunctions.end() ? generic->second->isAsync()
+                                                           : F && AsyncFunctions.count(F);
+            if (!async) {
+                return true;
+            }
+        } else if (auto* ifStmt = dynamic_cast<IfStmt*>(stmt.get())) {
+            if (spawnsTasks(ifStmt->getThen()) || spawnsTasks(ifStmt->getElse())) {
+                return true;
+            }
+        } else if (auto* whileStmt = dynamic_cast<WhileStmt*>(stmt.get())) {
+            if (spawnsTasks(whileStmt->getBody())) {
+                return true;
+            }
+        } else if (auto* forStmt = dynamic_cast<ForStmt*>(stmt.get())) {
+            if (spawnsTasks(forStmt->getBody())) {
+                return true;
+            }
+        } else if (auto* region = dynamic_cast<RegionStmt*>(stmt.get())) {
+            if (spawnsTasks(region->getBody())) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+llvm::AllocaInst* CodeGen::createEntryBlockAlloca(llvm::Type* type, const llvm::Twine& name) {
+    llvm::BasicBlock& Entry = Builder->GetInsertBlock()->getParent()->getEntryBlock();
+    llvm::IRBuilder<> EntryBuilder(&Entry, Entry.begin());
+    return EntryBuilder.CreateAlloca(type, nullptr, name);
+}
+
+void CodeGen::visit(RegionStmt& stmt) {
+    // Entering and leaving a region changes the thread's allocator.
+    if (CurrentFunction->hasAttr(FA_Pure)) {
+        std::cerr << "CodeGen Error: Pure function '" << CurrentFunction->getName()
+                  << "' cannot contain a region." << std::endl;
+        return;
+    }
+
+    // The runtime allocates the tasks spawned inside from the region; see
+    // "Regions" in docs/pipeline.md. Its sa_region is five pointers; see
+    // runtime/alloc.h.
+    const llvm::DataLayout& DL = TheModule->getDataLayout();
+    llvm::Type* RegionTy = llvm::ArrayType::get(Builder->getIntPtrTy(DL), 5);
+    llvm::Value* Region = createEntryBlockAlloca(RegionTy, "region");
+    Builder->CreateCall(TheModule->getFunction("sa_region_enter"), {Region});
+
+    auto OuterNames = NamedValues;
+    ActiveRegions.push_back(Region);
+    for (const auto& bodyStmt : stmt.getBody()) {
+        bodyStmt->accept(*this);
+    }
+    ActiveRegions.pop_back();
+
+    // Tasks spawned so far may still be using memory from this region.
+    if (TaskGroup) {
+        Builder->CreateCall(TheModule->getFunction("sa_join"), {TaskGroup});
+    }
+    Builder->CreateCall(TheModule->getFunction("sa_region_exit"), {Region});
+
+    // Names declared inside end with the region, so nothing can refer to
+    // its memory once it has been released.
+    for (const auto& [name, value] : NamedValues) {
+        auto outer = OuterNames.find(name);
+        if (outer == OuterNames.end() || outer->second != value) {
+            RegionScopedNames.insert(name);
+        }
+    }
+    NamedValues = std::move(OuterNames);
+}
+
+llvm::Function* CodeGen::getSpawnThunk(llvm::Function* callee) {
+    std::string ThunkName = callee->getName().str() + ".spawn";
+    if (llvm::Function* Thunk = TheModule->getFunction(ThunkName)) {
+        return Thunk;
+    }
+
+    llvm::FunctionType* ThunkTy = llvm::FunctionType::get(
+        Builder->getVoidTy(), {Builder->getPtrTy()}, false);
+    llvm::Function* Thunk = llvm::Function::Create(ThunkTy, llvm::Function::InternalLinkage,
+                                                   ThunkName, TheModule.get());
+
+    llvm::IRBuilder<> ThunkBuilder(llvm::BasicBlock::Create(*TheContext, "entry", Thunk));
+    llvm::StructType* EnvTy = llvm::StructType::get(*TheContext, callee->getFunctionType()->params());
+    llvm::Value* Env = Thunk->getArg(0);
+
+    std::vector<llvm::Value*> ArgsV;
+    for (unsigned i = 0; i < EnvTy->getNumElements(); ++i) {
+        ArgsV.push_back(ThunkBuilder.CreateLoad(EnvTy->getElementType(i),
+                                                ThunkBuilder.CreateStructGEP(EnvTy, Env, i)));
+    }
+    ThunkBuilder.CreateCall(getCallee(callee), ArgsV);
+    ThunkBuilder.CreateRetVoid();
+    return Thunk;
+}
+
+// --- Async Functions ---
+// An async function is lowered with LLVM's switched-resume coroutines. A
+// call runs it until it first suspends and returns its handle; the caller
+// either awaits it or detaches it ('spawn'). A finished coroutine keeps
+// its frame at the final suspension point until its awaiter has read the
+// result and destroyed it, unless it was detached, in which case it frees
+// the frame itself. Coroutines are only resumed by the event loop, so a
+// chain of awaits that all complete without blocking never grows the
+// stack beyond the depth of the chain.
+
+llvm::StructType* CodeGen::getPromiseType(llvm::Type* result) {
+    std::vector<llvm::Type*> Elements = {Builder->getPtrTy(), Builder->getInt8Ty()};
+    if (!result->isVoidTy()) {
+        Elements.push_back(result);
+    }
+    return llvm::StructType::get(*TheContext, Elements);
+}
+
+llvm::Align CodeGen::getPromiseAlign(llvm::StructType* promiseTy) {
+    return TheModule->getDataLayout().getABITypeAlign(promiseTy);
+}
+
+void CodeGen::declareAsync(const FunctionDecl& decl, llvm::Function* F) {
+    // 'main' itself is not a coroutine; see emitAsyncMain().
+    if (!decl.isAsync() || decl.getName() == "main") {
+        return;
+    }
+    if (llvm::Type* ResultTy = getLLVMType(decl.getReturnType())) {
+        AsyncFunctions[F] = getPromiseType(ResultTy);
+    }
+}
+
+void CodeGen::emitCoroutineBegin(llvm::StructType* promiseTy) {
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    F->setPresplitCoroutine();
+    llvm::PointerType* PtrTy = Builder->getPtrTy();
+    llvm::Value* Null = llvm::ConstantPointerNull::get(PtrTy);
+
+    auto Coro = std::make_unique<Coroutine>();
+    Coro->PromiseTy = promiseTy;
+    Coro->Promise = createEntryBlockAlloca(promiseTy, "promise");
+    Coro->Promise->setAlignment(getPromiseAlign(promiseTy));
+    Coro->Id = Builder->CreateIntrinsic(
+        llvm::Intrinsic::coro_id, {},
+        {Builder->getInt32(getPromiseAlign(promiseTy).value()), Coro->Promise, Null, Null});
+
+    // The frame comes from the runtime's pools unless LLVM can place it in
+    // the frame of the caller.
+    llvm::BasicBlock* Entry = Builder->GetInsertBlock();
+    llvm::BasicBlock* AllocBB = llvm::BasicBlock::Create(*TheContext, "coro.alloc", F);
+    llvm::BasicBlock* BeginBB = llvm::BasicBlock::Create(*TheContext, "coro.begin", F);
+    Builder->CreateCondBr(Builder->CreateIntrinsic(llvm::Intrinsic::coro_alloc, {}, {Coro->Id}),
+                          AllocBB, BeginBB);
+    Builder->SetInsertPoint(AllocBB);
+    llvm::Value* Size = Builder->CreateIntrinsic(llvm::Intrinsic::coro_size, {Builder->getInt64Ty()}, {});
+    llvm::Value* Memory = Builder->CreateCall(TheModule->getFunction("sa_pool_alloc"), {Size});
+    Builder->CreateBr(BeginBB);
+
+    Builder->SetInsertPoint(BeginBB);
+    llvm::PHINode* Frame = Builder->CreatePHI(PtrTy, 2, "frame");
+    Frame->addIncoming(Null, Entry);
+    Frame->addIncoming(Memory, AllocBB);
+    Coro->Handle = Builder->CreateIntrinsic(llvm::Intrinsic::coro_begin, {}, {Coro->Id, Frame});
+    Builder->CreateStore(Null, Builder->CreateStructGEP(promiseTy, Coro->Promise, 0));
+    Builder->CreateStore(Builder->getInt8(0), Builder->CreateStructGEP(promiseTy, Coro->Promise, 1));
+
+    // Filled in and moved behind the body by emitCoroutineEnd().
+    Coro->Final = llvm::BasicBlock::Create(*TheContext, "coro.final", F);
+    Coro->Cleanup = llvm::BasicBlock::Create(*TheContext, "coro.cleanup", F);
+    Coro->Suspend = llvm::BasicBlock::Create(*TheContext, "coro.suspend", F);
+    CurrentCoroutine = std::move(Coro);
+}
+
+void CodeGen::emitCoroutineEnd() {
+    Coroutine& Coro = *CurrentCoroutine;
+    llvm::Function* F = Coro.Final->getParent();
+    Coro.Final->moveAfter(&F->back());
+    Coro.Cleanup->moveAfter(Coro.Final);
+    Coro.Suspend->moveAfter(Coro.Cleanup);
+    llvm::Type* PtrTy = Builder->getPtrTy();
+
+    // Mark the result ready. A detached coroutine has no one to read it
+    // and frees its frame right away; otherwise the awaiter, if it is
+    // already waiting, is queued to run.
+    Builder->SetInsertPoint(Coro.Final);
+    llvm::Value* StatePtr = Builder->CreateStructGEP(Coro.PromiseTy, Coro.Promise, 1);
+    llvm::Value* State = Builder->CreateLoad(Builder->getInt8Ty(), StatePtr, "state");
+    Builder->CreateStore(Builder->CreateOr(State, PS_Done), StatePtr);
+    llvm::BasicBlock* NotifyBB = llvm::BasicBlock::Create(*TheContext, "coro.notify", F, Coro.Cleanup);
+    llvm::BasicBlock* WakeBB = llvm::BasicBlock::Create(*TheContext, "coro.wake", F, Coro.Cleanup);
+    llvm::BasicBlock* FinalSuspendBB =
+        llvm::BasicBlock::Create(*TheContext, "coro.final.suspend", F, Coro.Cleanup);
+    llvm::BasicBlock* ResumedBB = llvm::BasicBlock::Create(*TheContext, "coro.final.resumed", F, Coro.Cleanup);
+    Builder->CreateCondBr(Builder->CreateICmpNE(Builder->CreateAnd(State, PS_Detached), Builder->getInt8(0)),
+                          Coro.Cleanup, NotifyBB);
+
+    Builder->SetInsertPoint(NotifyBB);
+    llvm::Value* Awaiter = Builder->CreateLoad(
+        PtrTy, Builder->CreateStructGEP(Coro.PromiseTy, Coro.Promise, 0), "awaiter");
+    Builder->CreateCondBr(Builder->CreateIsNotNull(Awaiter), WakeBB, FinalSuspendBB);
+    Builder->SetInsertPoint(WakeBB);
+    Builder->CreateCall(TheModule->getFunction("sa_async_ready"), {Awaiter});
+    Builder->CreateBr(FinalSuspendBB);
+
+    // Nothing resumes a coroutine that has finished.
+    Builder->SetInsertPoint(FinalSuspendBB);
+    llvm::Value* Suspended = Builder->CreateIntrinsic(
+        llvm::Intrinsic::coro_suspend, {}, {llvm::ConstantTokenNone::get(*TheContext), Builder->getTrue()});
+    llvm::SwitchInst* Switch = Builder->CreateSwitch(Suspended, Coro.Suspend, 2);
+    Switch->addCase(Builder->getInt8(0), ResumedBB);
+    Switch->addCase(Builder->getInt8(1), Coro.Cleanup);
+    Builder->SetInsertPoint(ResumedBB);
+    Builder->CreateUnreachable();
+
+    // Free the frame, unless LLVM placed it in the caller's.
+    Builder->SetInsertPoint(Coro.Cleanup);
+    llvm::Value* Memory = Builder->CreateIntrinsic(llvm::Intrinsic::coro_free, {}, {Coro.Id, Coro.Handle});
+    llvm::BasicBlock* FreeBB = llvm::BasicBlock::Create(*TheContext, "coro.free", F, Coro.Suspend);
+    Builder->CreateCondBr(Builder->CreateIsNotNull(Memory), FreeBB, Coro.Suspend);
+    Builder->SetInsertPoint(FreeBB);
+    llvm::Value* Size = Builder->CreateIntrinsic(llvm::Intrinsic::coro_size, {Builder->getInt64Ty()}, {});
+    Builder->CreateCall(TheModule->getFunction("sa_pool_free"), {Memory, Size});
+    Builder->CreateBr(Coro.Suspend);
+
+    // Back to whoever started or resumed the coroutine; the start returns
+    // the handle.
+    Builder->SetInsertPoint(Coro.Suspend);
+    Builder->CreateIntrinsic(llvm::Intrinsic::coro_end, {},
+                             {Coro.Handle, Builder->getFalse(), llvm::ConstantTokenNone::get(*TheContext)});
+    Builder->CreateRet(Coro.Handle);
+}
+
+void CodeGen::emitSuspend(llvm::BasicBlock* resume) {
+    llvm::Value* Suspended = Builder->CreateIntrinsic(
+        llvm::Intrinsic::coro_suspend, {}, {llvm::ConstantTokenNone::get(*TheContext), Builder->getFalse()});
+    // Nothing destroys a suspended coroutine, but LLVM wants a way out for
+    // it to take.
+    llvm::SwitchInst* Switch = Builder->CreateSwitch(Suspended, CurrentCoroutine->Suspend, 2);
+    Switch->addCase(Builder->getInt8(0), resume);
+    Switch->addCase(Builder->getInt8(1), CurrentCoroutine->Cleanup);
+    Builder->SetInsertPoint(resume);
+}
+
+void CodeGen::emitDetach(llvm::Value* handle, llvm::StructType* promiseTy) {
+    llvm::Value* Promise = Builder->CreateIntrinsic(
+        llvm::Intrinsic::coro_promise, {},
+        {handle, Builder->getInt32(getPromiseAlign(promiseTy).value()), Builder->getFalse()});
+    llvm::Value* StatePtr = Builder->CreateStructGEP(promiseTy, Promise, 1);
+    llvm::Value* State = Builder->CreateLoad(Builder->getInt8Ty(), StatePtr, "state");
+
+    // If it already finished, its frame is only waiting to be destroyed.
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* DestroyBB = llvm::BasicBlock::Create(*TheContext, "detach.destroy", F);
+    llvm::BasicBlock* DetachBB = llvm::BasicBlock::Create(*TheContext, "detach", F);
+    llvm::BasicBlock* EndBB = llvm::BasicBlock::Create(*TheContext, "detach.end", F);
+    Builder->CreateCondBr(Builder->CreateICmpNE(Builder->CreateAnd(State, PS_Done), Builder->getInt8(0)),
+                          DestroyBB, DetachBB);
+    Builder->SetInsertPoint(DestroyBB);
+    Builder->CreateIntrinsic(llvm::Intrinsic::coro_destroy, {}, {handle});
+    Builder->CreateBr(EndBB);
+    Builder->SetInsertPoint(DetachBB);
+    Builder->CreateStore(Builder->CreateOr(State, PS_Detached), StatePtr);
+    Builder->CreateBr(EndBB);
+    Builder->SetInsertPoint(EndBB);
+}
+
+void CodeGen::emitAwaitIO(CallExpr& call, const AsyncIOOperation& op) {
+    llvm::Function* IO = TheModule->getFunction(op.Function);
+    std::vector<llvm::Value*> ArgsV;
+    for (const auto& arg : call.getArgs()) {
+        arg->accept(*this);
+        if (!V) {
+            return;
+        }
+        appendLoweredArg(V, ArgsV);
+    }
+    llvm::Value* Data = nullptr;
+    if (op.ReturnsStr) {
+        Data = createEntryBlockAlloca(Builder->getPtrTy(), "io.data");
+        ArgsV.push_back(Data);
+    }
+    llvm::FunctionType* FT = IO->getFunctionType();
+    bool matches = ArgsV.size() == FT->getNumParams();
+    for (size_t i = 0; matches && i < ArgsV.size(); ++i) {
+        matches = ArgsV[i]->getType() == FT->getParamType(i);
+    }
+    if (!matches) {
+        std::cerr << "CodeGen Error: The arguments of the call to '" << op.Name
+                  << "' do not match its parameters." << std::endl;
+        V = nullptr;
+        return;
+    }
+
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* RetryBB = llvm::BasicBlock::Create(*TheContext, "io.retry", F);
+    llvm::BasicBlock* WaitBB = llvm::BasicBlock::Create(*TheContext, "io.wait", F);
+    llvm::BasicBlock* DoneBB = llvm::BasicBlock::Create(*TheContext, "io.done", F);
+    Builder->CreateBr(RetryBB);
+    Builder->SetInsertPoint(RetryBB);
+    llvm::Value* Result = Builder->CreateCall(IO, ArgsV, "io");
+    Builder->CreateCondBr(Builder->CreateICmpEQ(Result, Builder->getInt64(IOPending)), WaitBB, DoneBB);
+
+    Builder->SetInsertPoint(WaitBB);
+    Builder->CreateCall(TheModule->getFunction("sa_io_wait"),
+                        {ArgsV[0], Builder->getInt64(op.Writes), CurrentCoroutine->Handle});
+    emitSuspend(RetryBB);
+
+    Builder->SetInsertPoint(DoneBB);
+    V = Result;
+    if (op.ReturnsStr) {
+        // The end of the stream and errors read as an empty 'str'.
+        llvm::Value* Got = Builder->CreateICmpSGT(Result, Builder->getInt64(0));
+        llvm::Value* Ptr = Builder->CreateSelect(Got, Builder->CreateLoad(Builder->getPtrTy(), Data),
+                                                 llvm::ConstantPointerNull::get(Builder->getPtrTy()));
+        llvm::Value* Len = Builder->CreateSelect(Got, Result, Builder->getInt64(0));
+        V = Builder->CreateInsertValue(llvm::PoisonValue::get(StrTy), Ptr, 0);
+        V = Builder->CreateInsertValue(V, Len, 1);
+    }
+}
+
+void CodeGen::emitAsyncMain(FunctionDecl& decl, llvm::Function* Main) {
+    // The body becomes a coroutine of its own. 'main' starts it and runs
+    // the event loop until every coroutine has finished.
+    llvm::Function* Body = llvm::Function::Create(
+        llvm::FunctionType::get(Builder->getPtrTy(), false), llvm::Function::InternalLinkage,
+        "main.async", TheModule.get());
+    applyFunctionAttrs(decl, Body);
+    AsyncFunctions[Body] = getPromiseType(Builder->getVoidTy());
+    emitFunctionBody(decl, Body);
+
+    Builder->SetInsertPoint(llvm::BasicBlock::Create(*TheContext, "entry", Main));
+    emitDetach(Builder->CreateCall(Body, {}, "task"), AsyncFunctions[Body]);
+    Builder->CreateCall(TheModule->getFunction("sa_async_run"));
+    Builder->CreateRet(Builder->getInt32(0));
+    llvm::verifyFunction(*Main);
+}
+
+void CodeGen::optimize() {
+    // The optimizations query the target for the cost of instructions. -O0
+    // does not, so IR for a target LLVM was built without can still be
+    // printed.
+    llvm::PassBuilder PB(OptLevel > 0 ? getTargetMachine() : nullptr);
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+
+    // Even -O0 inlines '@inline' functions and splits coroutines, which the
+    // code generator cannot compile whole. Inlining the bodies of imported
+    // functions, and eliding coroutine frames into their caller's
+    // (CoroElide), take -O1 or above.
+    static const llvm::OptimizationLevel Levels[] = {
+        llvm::OptimizationLevel::O0, llvm::OptimizationLevel::O1,
+        llvm::OptimizationLevel::O2, llvm::OptimizationLevel::O3,
+    };
+    llvm::ModulePassManager MPM = OptLevel == 0
+        ? PB.buildO0DefaultPipeline(llvm::OptimizationLevel::O0)
+        : PB.buildPerModuleDefaultPipeline(Levels[OptLevel]);
+    MPM.run(*TheModule, MAM);
+}
+
+void CodeGen::visit(StringLiteralExpr& expr) {
+    // The bytes need no terminator: the length is a constant right here.
+    std::string_view Value = expr.getValue();
+    llvm::Constant* Bytes = llvm::ConstantDataArray::getString(
+        *TheContext, llvm::StringRef(Value.data(), Value.size()), /*AddNull=*/false);
+    auto* GV = new llvm::GlobalVariable(*TheModule, Bytes->getType(), /*isConstant=*/true,
+                                        llvm::GlobalValue::PrivateLinkage, Bytes, ".str");
+    GV->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global);
+    GV->setAlignment(llvm::Align(1));
+    V = llvm::ConstantStruct::get(StrTy, {GV, Builder->getInt64(Value.size())});
+}
+
+void CodeGen::visit(IntegerLiteralExpr& expr) {
+    uint64_t Value;
+    if (llvm::StringRef(expr.getLexeme()).getAsInteger(10, Value) ||
+        Value > uint64_t(std::numeric_limits<int64_t>::max())) {
+        std::cerr << "CodeGen Error: Integer literal '" << expr.getLexeme()
+                  << "' does not fit in 'i64'." << std::endl;
+        V = nullptr;
+        return;
+    }
+    V = Builder->getInt64(Value);
+}
+
+void CodeGen::visit(BoolLiteralExpr& expr) {
+    V = Builder->getInt1(expr.getValue());
+}
+
+void CodeGen::visit(BinaryExpr& expr) {
+    expr.getLHS()->accept(*this);
+    llvm::Value* L = V;
+    if (!L) {
+        return;
+    }
+    expr.getRHS()->accept(*this);
+    llvm::Value* R = V;
+    if (!R) {
+        return;
+    }
+
+    bool Ints = L->getType()->isIntegerTy(64) && R->getType()->isIntegerTy(64);
+    bool Bools = L->getType()->isIntegerTy(1) && R->getType()->isIntegerTy(1);
+    V = nullptr;
+    switch (expr.getOp()) {
+        case tok::plus:          if (Ints) V = Builder->CreateAdd(L, R, "add"); break;
+        case tok::minus:         if (Ints) V = Builder->CreateSub(L, R, "sub"); break;
+        case tok::star:          if (Ints) V = Builder->CreateMul(L, R, "mul"); break;
+        case tok::slash:
+            if (Ints) {
+                emitDivisionCheck(L, R);
+                V = Builder->CreateSDiv(L, R, "div");
+            }
+            break;
+        case tok::percent:
+            if (Ints) {
+                emitDivisionCheck(L, R);
+                V = Builder->CreateSRem(L, R, "rem");
+            }
+            break;
+        case tok::less:          if (Ints) V = Builder->CreateICmpSLT(L, R, "cmp"); break;
+        case tok::less_equal:    if (Ints) V = Builder->CreateICmpSLE(L, R, "cmp"); break;
+        case tok::greater:       if (Ints) V = Builder->CreateICmpSGT(L, R, "cmp"); break;
+        case tok::greater_equal: if (Ints) V = Builder->CreateICmpSGE(L, R, "cmp"); break;
+        case tok::equal_equal:   if (Ints || Bools) V = Builder->CreateICmpEQ(L, R, "cmp"); break;
+        case tok::bang_equal:    if (Ints || Bools) V = Builder->CreateICmpNE(L, R, "cmp"); break;
+        default: break;
+    }
+    if (!V) {
+        std::cerr << "CodeGen Error: Operator '" << expr.getOpSpelling() << "' cannot be applied to '"
+                  << getTypeOf(L->getType()).getName() << "' and '"
+                  << getTypeOf(R->getType()).getName() << "'." << std::endl;
+    }
+}
+
+void CodeGen::visit(VariableExpr& expr) {
+    llvm::AllocaInst* VarAlloca = lookupVariable(expr.getName());
+    if (!VarAlloca) {
+        V = nullptr;
+        return;
+    }
+    V = Builder->CreateLoad(VarAlloca->getAllocatedType(), VarAlloca, expr.getName());
+}
+
+llvm::AllocaInst* CodeGen::lookupVariable(std::string_view name) {
+    auto it = NamedValues.find(name);
+    if (it != NamedValues.end()) {
+        return static_cast<llvm::AllocaInst*>(it->second);
+    }
+    if (RegionScopedNames.count(name)) {
+        std::cerr << "CodeGen Error: '" << name
+                  << "' was declared inside a region and cannot be used after it ends." << std::endl;
+        return nullptr;
+    }
+    std::cerr << "CodeGen Error: Unknown variable name '" << name << "'." << std::endl;
+    return nullptr;
+}
+
+void CodeGen::visit(StructLiteralExpr& expr) {
+    auto it = Structs.find(expr.getName());
+    if (it == Structs.end()) {
+        std::cerr << "CodeGen Error: Unknown struct '" << expr.getName() << "'." << std::endl;
+        V = nullptr;
+        return;
+    }
+    const StructInfo& Info = it->second;
+    const auto& Fields = Info.Decl->getFields();
+
+    llvm::Value* Value = llvm::PoisonValue::get(Info.Ty);
+    std::vector<bool> Given(Fields.size());
+    for (const auto& [name, init] : expr.getFields()) {
+        size_t Index = 0;
+        while (Index < Fields.size() && Fields[Index].Name.lexeme != name.lexeme) {
+            ++Index;
+        }
+        if (Index == Fields.size()) {
+            std::cerr << "CodeGen Error: Struct '" << expr.getName() << "' has no field '"
+                      << name.lexeme << "'." << std::endl;
+            V = nullptr;
+            return;
+        }
+        if (Given[Index]) {
+            std::cerr << "CodeGen Error: Field '" << name.lexeme << "' of '" << expr.getName()
+                      << "' is given more than once." << std::endl;
+            V = nullptr;
+            return;
+        }
+        Given[Index] = true;
+
+        init->accept(*this);
+        if (!V) {
+            return;
+        }
+        llvm::Type* FieldTy = Info.Ty->getElementType(Info.FieldIndices[Index]);
+        if (V->getType() != FieldTy) {
+            std::cerr << "CodeGen Error: Field '" << name.lexeme << "' of '" << expr.getName()
+                      << "' is a '" << getTypeOf(FieldTy).getName() << "', not a '"
+                      << getTypeOf(V->getType()).getName() << "'." << std::endl;
+            V = nullptr;
+            return;
+        }
+        Value = Builder->CreateInsertValue(Value, V, Info.FieldIndices[Index]);
+    }
+
+    for (size_t i = 0; i < Fields.size(); ++i) {
+        if (!Given[i]) {
+            std::cerr << "CodeGen Error: Field '" << Fields[i].Name.lexeme << "' of '"
+                      << expr.getName() << "' is missing." << std::endl;
+            V = nullptr;
+            return;
+        }
+    }
+    V = Value;
+}
+
+void CodeGen::visit(FieldExpr& expr) {
+    Place P;
+    if (!emitPlace(*expr.getBase(), P)) {
+        V = nullptr;
+        return;
+    }
+    // Arrays, slices and strings have a length instead of fields.
+    bool HasLength = P.Ty.isArray() || P.Ty.isSlice() || P.Ty.getKind() == TypeKind::Str;
+    if (HasLength && expr.getName() == "len") {
+        V = emitLength(P);
+        return;
+    }
+    V = emitFieldPlace(P, expr.getName()) ? loadPlace(P) : nullptr;
+}
+
+void CodeGen::visit(IndexExpr& expr) {
+    Place P;
+    V = emitPlace(expr, P) ? loadPlace(P) : nullptr;
+}
+
+void CodeGen::visit(SliceExpr& expr) {
+    V = nullptr;
+    Place P;
+    if (!emitPlace(*expr.getBase(), P)) {
+        return;
+    }
+
+    llvm::Value* Ptr;
+    llvm::Value* Length;
+    llvm::Type* ElementTy;
+    llvm::StructType* SliceTy;
+    if (P.Ty.isArray()) {
+        llvm::Type* ArrayTy = getLLVMType(P.Ty);
+        if (!ArrayTy->isArrayTy()) {
+            std::cerr << "CodeGen Error: An array of '@soa' struct '" << P.Ty.getElementType().getName()
+                      << "' cannot be sliced; its elements are not stored in one piece." << std::endl;
+            return;
+        }
+        Ptr = P.Addr;
+        Length = Builder->getInt64(P.Ty.getLength());
+        ElementTy = ArrayTy->getArrayElementType();
+        SliceTy = getSliceType(P.Ty.getElementType());
+    } else if (P.Ty.isSlice() || P.Ty.getKind() == TypeKind::Str) {
+        SliceTy = llvm::cast<llvm::StructType>(getLLVMType(P.Ty));
+        Ptr = Builder->CreateLoad(Builder->getPtrTy(), Builder->CreateStructGEP(SliceTy, P.Addr, 0));
+        Length = emitLength(P);
+        ElementTy = P.Ty.isSlice() ? getLLVMType(P.Ty.getElementType()) : Builder->getInt8Ty();
+    } else {
+        std::cerr << "CodeGen Error: Only arrays, slices and strings can be sliced, not a '"
+                  << P.Ty.getName() << "'." << std::endl;
+        return;
+    }
+
+    llvm::Value* Bounds[2];
+    Expr* BoundExprs[2] = {expr.getLo(), expr.getHi()};
+    for (int i = 0; i < 2; ++i) {
+        BoundExprs[i]->accept(*this);
+        if (!V) {
+            return;
+        }
+        if (!V->getType()->isIntegerTy(64)) {
+            std::cerr << "CodeGen Error: The bounds of a slice must be 'i64's, not '"
+                      << getTypeOf(V->getType()).getName() << "'." << std::endl;
+            V = nullptr;
+            return;
+        }
+        Bounds[i] = V;
+    }
+    llvm::Value* Lo = Bounds[0];
+    llvm::Value* Hi = Bounds[1];
+
+    // 0 <= lo <= hi <= len. Compared unsigned, a negative bound is larger
+    // than any length.
+    ++getBoundsStats().Kept;
+    if (BoundsChecks != BoundsCheckMode::Off) {
+        llvm::Value* HiInRange = Builder->CreateICmpULE(Hi, Length);
+        emitBoundsCheck(Builder->CreateAnd(Builder->CreateICmpULE(Lo, Hi), HiInRange),
+                        Builder->CreateSelect(HiInRange, Lo, Hi), Length);
+    }
+
+    llvm::Value* Slice = llvm::PoisonValue::get(SliceTy);
+    Slice = Builder->CreateInsertValue(Slice, Builder->CreateInBoundsGEP(ElementTy, Ptr, Lo), 0);
+    V = Builder->CreateInsertValue(Slice, Builder->CreateSub(Hi, Lo), 1);
+}
+
+llvm::Value* CodeGen::emitLength(const Place& place) {
+    if (place.Ty.isArray()) {
+        return Builder->getInt64(place.Ty.getLength());
+    }
+    llvm::Type* FatTy = getLLVMType(place.Ty);
+    return Builder->CreateLoad(Builder->getInt64Ty(), Builder->CreateStructGEP(FatTy, place.Addr, 1), "len");
+}
+
+void CodeGen::emitBoundsCheck(llvm::Value* inBounds, llvm::Value* index, llvm::Value* length) {
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* FailBB = llvm::BasicBlock::Create(*TheContext, "bounds.fail", F);
+    llvm::BasicBlock* OkBB = llvm::BasicBlock::Create(*TheContext, "bounds.ok", F);
+    llvm::MDBuilder MDB(*TheContext);
+    Builder->CreateCondBr(inBounds, OkBB, FailBB, MDB.createBranchWeights(1 << 20, 1));
+
+    Builder->SetInsertPoint(FailBB);
+    Builder->CreateCall(TheModule->getFunction("sa_bounds_fail"), {index, length});
+    Builder->CreateUnreachable();
+
+    Builder->SetInsertPoint(OkBB);
+}
+
+void CodeGen::emitDivisionCheck(llvm::Value* dividend, llvm::Value* divisor) {
+    // Any other constant divisor is safe.
+    auto* Constant = llvm::dyn_cast<llvm::ConstantInt>(divisor);
+    if (Constant && !Constant->isZero() && !Constant->isMinusOne()) {
+        return;
+    }
+
+    // Dividing the smallest i64 by -1 overflows, and LLVM leaves it, like
+    // dividing by zero, undefined.
+    llvm::Value* Overflows = Builder->CreateAnd(
+        Builder->CreateICmpEQ(dividend, Builder->getInt64(std::numeric_limits<int64_t>::min())),
+        Builder->CreateICmpEQ(divisor, Builder->getInt64(-1)));
+    llvm::Value* Fails = Builder->CreateOr(Builder->CreateICmpEQ(divisor, Builder->getInt64(0)),
+                                           Overflows);
+
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* FailBB = llvm::BasicBlock::Create(*TheContext, "div.fail", F);
+    llvm::BasicBlock* OkBB = llvm::BasicBlock::Create(*TheContext, "div.ok", F);
+    llvm::MDBuilder MDB(*TheContext);
+    Builder->CreateCondBr(Fails, FailBB, OkBB, MDB.createBranchWeights(1, 1 << 20));
+
+    Builder->SetInsertPoint(FailBB);
+    Builder->CreateCall(TheModule->getFunction("sa_div_fail"), {dividend, divisor});
+    Builder->CreateUnreachable();
+
+    Builder->SetInsertPoint(OkBB);
+}
+
+CodeGen::BoundsCheckStats& CodeGen::getBoundsStats() {
+    return BoundsStats[Builder->GetInsertBlock()->getParent()->getName().str()];
+}
+
+void CodeGen::visit(AssignStmt& stmt) {
+    stmt.getValue()->accept(*this);
+    llvm::Value* Value = V;
+    Place P;
+    if (!Value || !emitPlace(*stmt.getTarget(), P)) {
+        return;
+    }
+    // A pure function may only write its own locals. Anything reached
+    // through a slice could be the caller's memory.
+    if (CurrentFunction->hasAttr(FA_Pure) &&
+        !llvm::isa<llvm::AllocaInst>(llvm::getUnderlyingObject(P.Addr))) {
+        std::cerr << "CodeGen Error: Pure function '" << CurrentFunction->getName()
+                  << "' cannot assign to memory it does not own." << std::endl;
+        return;
+    }
+    Type ValueTy = getTypeOf(Value->getType());
+    if (ValueTy != P.Ty) {
+        std::cerr << "CodeGen Error: Cannot assign a '" << ValueTy.getName() << "' to a '"
+                  << P.Ty.getName() << "'." << std::endl;
+        return;
+    }
+    storePlace(P, Value);
+}
+
+bool CodeGen::emitPlace(Expr& expr, Place& place) {
+    if (auto* Var = dynamic_cast<VariableExpr*>(&expr)) {
+        llvm::AllocaInst* Alloca = lookupVariable(Var->getName());
+        if (!Alloca) {
+            return false;
+        }
+        place = Place{Alloca, getTypeOf(Alloca->getAllocatedType())};
+        return true;
+    }
+
+    if (auto* FieldAccess = dynamic_cast<FieldExpr*>(&expr)) {
+        return emitPlace(*FieldAccess->getBase(), place) &&
+               emitFieldPlace(place, FieldAccess->getName());
+    }
+
+    if (auto* Element = dynamic_cast<IndexExpr*>(&expr)) {
+        if (!emitPlace(*Element->getBase(), place)) {
+            return false;
+        }
+        if (!place.Ty.isArray() && !place.Ty.isSlice()) {
+            std::cerr << "CodeGen Error: Only arrays and slices can be indexed, not a '"
+                      << place.Ty.getName() << "'." << std::endl;
+            return false;
+        }
+        Element->getIndex()->accept(*this);
+        if (!V) {
+            return false;
+        }
+        if (!V->getType()->isIntegerTy(64)) {
+            std::cerr << "CodeGen Error: An index must be an 'i64', not a '"
+                      << getTypeOf(V->getType()).getName() << "'." << std::endl;
+            return false;
+        }
+        llvm::Value* Index = V;
+
+        BoundsCheckStats& Stats = getBoundsStats();
+        switch (Element->getBoundsCheck()) {
+            case BoundsCheck::Proven:  ++Stats.Removed; break;
+            case BoundsCheck::Hoisted: ++Stats.Hoisted; break;
+            case BoundsCheck::Needed:
+                ++Stats.Kept;
+                if (BoundsChecks != BoundsCheckMode::Off) {
+                    llvm::Value* Length = emitLength(place);
+                    emitBoundsCheck(Builder->CreateICmpULT(Index, Length), Index, Length);
+                }
+                break;
+        }
+
+        Type ElementTy = place.Ty.getElementType();
+        if (place.Ty.isSlice()) {
+            llvm::Type* SliceTy = getLLVMType(place.Ty);
+            llvm::Value* Ptr = Builder->CreateLoad(Builder->getPtrTy(),
+                                                   Builder->CreateStructGEP(SliceTy, place.Addr, 0));
+            place = Place{Builder->CreateInBoundsGEP(getLLVMType(ElementTy), Ptr, Index), ElementTy};
+            return true;
+        }
+
+        llvm::Type* ArrayTy = getLLVMType(place.Ty);
+        if (auto* Columns = llvm::dyn_cast<llvm::StructType>(ArrayTy)) {
+            place = Place{place.Addr, ElementTy, Columns, Index};
+        } else {
+            llvm::Value* Addr = Builder->CreateInBoundsGEP(ArrayTy, place.Addr,
+                                                           {Builder->getInt64(0), Index});
+            place = Place{Addr, ElementTy};
+        }
+        return true;
+    }
+
+    // Any other expression is a value that is not stored anywhere yet.
+    expr.accept(*this);
+    if (!V) {
+        return false;
+    }
+    llvm::AllocaInst* Temp = createEntryBlockAlloca(V->getType(), "tmp");
+    Builder->CreateStore(V, Temp);
+    place = Place{Temp, getTypeOf(V->getType())};
+    return true;
+}
+
+bool CodeGen::emitFieldPlace(Place& place, std::string_view name) {
+    if (!place.Ty.isStruct()) {
+        std::cerr << "CodeGen Error: A '" << place.Ty.getName() << "' has no field '"
+                  << name << "'." << std::endl;
+        return false;
+    }
+    const StructInfo& Info = Structs.at(place.Ty.getIdentifier());
+    const auto& Fields = Info.Decl->getFields();
+    unsigned Index = 0;
+    while (Index < Fields.size() && Fields[Index].Name.lexeme != name) {
+        ++Index;
+    }
+    if (Index == Fields.size()) {
+        std::cerr << "CodeGen Error: Struct '" << place.Ty.getName() << "' has no field '"
+                  << name << "'." << std::endl;
+        return false;
+    }
+
+    llvm::Type* FieldTy = Info.Ty->getElementType(Info.FieldIndices[Index]);
+    llvm::Value* Addr;
+    if (place.Columns) {
+        Addr = Builder->CreateInBoundsGEP(place.Columns, place.Addr,
+                                          {Builder->getInt32(0), Builder->getInt32(Index), place.Index});
+    } else {
+        Addr = Builder->CreateStructGEP(Info.Ty, place.Addr, Info.FieldIndices[Index]);
+    }
+    place = Place{Addr, getTypeOf(FieldTy)};
+    return true;
+}
+
+llvm::Value* CodeGen::loadPlace(const Place& place) {
+    if (!place.Columns) {
+        return Builder->CreateLoad(getLLVMType(place.Ty), place.Addr);
+    }
+
+    // Gather the element from its columns.
+    const StructInfo& Info = Structs.at(place.Ty.getIdentifier());
+    llvm::Value* Value = llvm::PoisonValue::get(Info.Ty);
+    for (unsigned i = 0; i < Info.FieldIndices.size(); ++i) {
+        llvm::Value* Addr = Builder->CreateInBoundsGEP(place.Columns, place.Addr,
+                                                       {Builder->getInt32(0), Builder->getInt32(i), place.Index});
+        llvm::Value* Field = Builder->CreateLoad(Info.Ty->getElementType(Info.FieldIndices[i]), Addr);
+        Value = Builder->CreateInsertValue(Value, Field, Info.FieldIndices[i]);
+    }
+    return Value;
+}
+
+void CodeGen::storePlace(const Place& place, llvm::Value* value) {
+    if (!place.Columns) {
+        Builder->CreateStore(value, place.Addr);
+        return;
+    }
+
+    // Scatter the element into its columns.
+    const StructInfo& Info = Structs.at(place.Ty.getIdentifier());
+    for (unsigned i = 0; i < Info.FieldIndices.size(); ++i) {
+        llvm::Value* Addr = Builder->CreateInBoundsGEP(place.Columns, place.Addr,
+                                                       {Builder->getInt32(0), Builder->getInt32(i), place.Index});
+        Builder->CreateStore(Builder->CreateExtractValue(value, Info.FieldIndices[i]), Addr);
+    }
+}
+
+void CodeGen::visit(CallExpr& expr) {
+    std::string_view Name = expr.getCalleeName();
+    if (!lookupFunction(Name) && !GenericFunctions.count(Name) && findAsyncIOOperation(Name)) {
+        std::cerr << "CodeGen Error: '" << Name << "' must be called with 'await'." << std::endl;
+        V = nullptr;
+        return;
+    }
+
+    std::vector<llvm::Value*> ArgsV;
+    llvm::Function* CalleeF = emitCallee(expr, ArgsV);
+    if (!CalleeF) {
+        V = nullptr;
+        return;
+    }
+    if (AsyncFunctions.count(CalleeF)) {
+        std::cerr << "CodeGen Error: Async function '" << Name
+                  << "' must be called with 'await' or 'spawn'." << std::endl;
+        V = nullptr;
+        return;
+    }
+
+    // A pure function may only call other pure functions, otherwise the
+    // optimizer would delete side effects it was promised do not exist.
+    if (CurrentFunction && CurrentFunction->hasAttr(FA_Pure) && !CalleeF->onlyReadsMemory()) {
+        std::cerr << "CodeGen Error: Pure function '" << CurrentFunction->getName()
+                  << "' calls impure function '" << expr.getCalleeName() << "'." << std::endl;
+        V = nullptr;
+        return;
+    }
+
+    // Only give the call a name if it returns a non-void value
+    if (CalleeF->getReturnType()->isVoidTy()) {
+        V = Builder->CreateCall(getCallee(CalleeF), ArgsV);
+    } else {
+        V = Builder->CreateCall(getCallee(CalleeF), ArgsV, "calltmp");
+    }
+}
+
+void CodeGen::visit(AwaitExpr& expr) {
+    V = nullptr;
+    if (!CurrentCoroutine) {
+        std::cerr << "CodeGen Error: 'await' can only be used in an async function." << std::endl;
+        return;
+    }
+    // Regions are a stack per thread; other coroutines would allocate from
+    // this one's while it waits.
+    if (!ActiveRegions.empty()) {
+        std::cerr << "CodeGen Error: 'await' cannot be used inside a region." << std::endl;
+        return;
+    }
+
+    CallExpr& Call = *expr.getCall();
+    std::string_view Name = Call.getCalleeName();
+    if (!lookupFunction(Name) && !GenericFunctions.count(Name)) {
+        if (const AsyncIOOperation* op = findAsyncIOOperation(Name)) {
+            emitAwaitIO(Call, *op);
+            return;
+        }
+    }
+
+    std::vector<llvm::Value*> ArgsV;
+    llvm::Function* CalleeF = emitCallee(Call, ArgsV);
+    if (!CalleeF) {
+        return;
+    }
+    auto async = AsyncFunctions.find(CalleeF);
+    if (async == AsyncFunctions.end()) {
+        std::cerr << "CodeGen Error: '" << Name << "' is not async and cannot be awaited." << std::endl;
+        return;
+    }
+    llvm::StructType* PromiseTy = async->second;
+
+    // Start it. Unless it finished without suspending, leave our handle in
+    // its promise and suspend until it queues us.
+    llvm::Value* Handle = Builder->CreateCall(CalleeF, ArgsV, "task");
+    llvm::Value* Promise = Builder->CreateIntrinsic(
+        llvm::Intrinsic::coro_promise, {},
+        {Handle, Builder->getInt32(getPromiseAlign(PromiseTy).value()), Builder->getFalse()});
+    llvm::Value* State = Builder->CreateLoad(Builder->getInt8Ty(),
+                                             Builder->CreateStructGEP(PromiseTy, Promise, 1), "state");
+    llvm::Function* F = Builder->GetInsertBlock()->getParent();
+    llvm::BasicBlock* WaitBB = llvm::BasicBlock::Create(*TheContext, "await.wait", F);
+    llvm::BasicBlock* ReadyBB = llvm::BasicBlock::Create(*TheContext, "await.ready", F);
+    Builder->CreateCondBr(Builder->CreateICmpNE(Builder->CreateAnd(State, PS_Done), Builder->getInt8(0)),
+                          ReadyBB, WaitBB);
+    Builder->SetInsertPoint(WaitBB);
+    Builder->CreateStore(CurrentCoroutine->Handle, Builder->CreateStructGEP(PromiseTy, Promise, 0));
+    emitSuspend(ReadyBB);
+
+    llvm::Value* Result = nullptr;
+    if (PromiseTy->getNumElements() > 2) {
+        Result = Builder->CreateLoad(PromiseTy->getElementType(2),
+                                     Builder->CreateStructGEP(PromiseTy, Promise, 2), "result");
+    }
+    Builder->CreateIntrinsic(llvm::Intrinsic::coro_destroy, {}, {Handle});
+    if (!Result && &expr != DiscardedAwait) {
+        std::cerr << "CodeGen Error: Cannot use the result of void async function '" << Name
+                  << "'." << std::endl;
     }
+    V = Result;
 }
 
 llvm::Value* CodeGen::visitExpression(Expr* expr) {
@@ -0,0 +1,142 @@
+//===--- Linker.cpp - In-process Linking of 'sa' Programs -------*- C++ -*-===//
+//
+// This file implements linkExecutable.
+//
+// The link line is the one a C compiler driver would use for a
+// position-independent executable, with the start-up files and library
+// directories of the host C library that CMake found at configure time.
+// The minimal runtime brings its own '_start' and is linked on its own.
+//
+//===----------------------------------------------------------------------===//
+
+#include "backend/include/Linker.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/TargetParser/Host.h"
+#include <iostream>
+
+#ifdef SA_HAVE_LLD
+#include "lld/Common/Driver.h"
+LLD_HAS_DRIVER(elf)
+#endif
+
+namespace sa {
+
+namespace {
+
+// The program interpreter glibc installs for each architecture.
+const char* getDynamicLinker(const llvm::Triple& triple) {
+    switch (triple.getArch()) {
+    case llvm::Triple::x86_64:
+        return "/lib64/ld-linux-x86-64.so.2";
+    case llvm::Triple::aarch64:
+        return "/lib/ld-linux-aarch64.so.1";
+    case llvm::Triple::riscv64:
+        return "/lib/ld-linux-riscv64-lp64d.so.1";
+    default:
+        return nullptr;
+    }
+}
+
+// The runtime archives are installed next to 'sac' in a build tree, and in
+// the sibling 'lib' directory once installed.
+std::string findRuntimeLibrary(const char* argv0, const std::string& name) {
+    std::string exe = llvm::sys::fs::getMainExecutable(argv0, reinterpret_cast<void*>(&linkExecutable));
+    llvm::StringRef dir = llvm::sys::path::parent_path(exe);
+    for (const char* relative : {".", "../lib"}) {
+        llvm::SmallString<256> path(dir);
+        llvm::sys::path::append(path, relative, name);
+        if (llvm::sys::fs::exists(path)) {
+            return std::string(path);
+        }
+    }
+    return "";
+}
+
+#ifdef SA_HAVE_LLD
+// Runs the ELF linker on the command line 'args'.
+bool runLLD(const std::vector<std::string>& args) {
+    std::vector<const char*> argv;
+    for (const auto& arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    lld::Result result = lld::lldMain(argv, llvm::outs(), llvm::errs(), {{lld::Gnu, &lld::elf::link}});
+    return result.retCode == 0;
+}
+#endif
+
+} // namespace
+
+bool linkExecutable(const std::vector<std::string>& objects, const std::string& outputPath,
+                    const llvm::Triple& triple, const char* argv0, RuntimeKind runtimeKind) {
+    llvm::Triple host(llvm::sys::getProcessTriple());
+    if (!triple.isOSBinFormatELF() || triple.getArch() != host.getArch()) {
+        std::cerr << "Link Error: Linking is only supported for ELF targets matching the host ("
+                  << host.str() << "), not '" << triple.str() << "'." << std::endl;
+        return false;
+    }
+    bool minimal = runtimeKind == RuntimeKind::Minimal;
+    if (minimal && (!triple.isOSLinux() || (triple.getArch() != llvm::Triple::x86_64 &&
+                                            triple.getArch() != llvm::Triple::aarch64))) {
+        std::cerr << "Link Error: The minimal runtime supports Linux on x86-64 and AArch64 only, not '"
+                  << triple.str() << "'." << std::endl;
+        return false;
+    }
+    const char* dynamicLinker = getDynamicLinker(triple);
+    if (!minimal && !dynamicLinker) {
+        std::cerr << "Link Error: No known dynamic linker for '" << triple.str() << "'." << std::endl;
+        return false;
+    }
+    std::string runtimeName = minimal ? "libsa_runtime_minimal.a" : "libsa_runtime.a";
+    std::string runtime = findRuntimeLibrary(argv0, runtimeName);
+    if (runtime.empty()) {
+        std::cerr << "Link Error: Could not find " << runtimeName << " next to sac or in ../lib." << std::endl;
+        return false;
+    }
+
+#ifdef SA_HAVE_LLD
+    // Nothing but the objects and the runtime: a static executable entered
+    // at the runtime's '_start'.
+    if (minimal) {
+        std::vector<std::string> args = {"ld.lld", "-o", outputPath, "-static", "--gc-sections",
+                                          "-z", "noexecstack"};
+        args.insert(args.end(), objects.begin(), objects.end());
+        args.push_back(runtime);
+        return runLLD(args);
+    }
+#endif
+
+#if defined(SA_HAVE_LLD) && defined(SA_CRT_DIR)
+    std::string crtDir = SA_CRT_DIR;
+    std::string gccDir = SA_GCC_DIR;
+    std::string threadLibs = SA_THREAD_LIBS;
+
+    std::vector<std::string> args = {
+        "ld.lld", "-o", outputPath, "-pie", "--eh-frame-hdr",
+        "-dynamic-linker", dynamicLinker,
+        crtDir + "/Scrt1.o", crtDir + "/crti.o", gccDir + "/crtbeginS.o",
+        "-L" + gccDir, std::string("-L") + SA_LIBC_DIR,
+    };
+    args.insert(args.end(), objects.begin(), objects.end());
+    args.push_back(runtime);
+    if (!threadLibs.empty()) {
+        args.push_back(threadLibs);
+    }
+    for (const char* arg : {"-lc", "-lgcc", "--as-needed", "-lgcc_s", "--no-as-needed"}) {
+        args.push_back(arg);
+    }
+    args.push_back(gccDir + "/crtendS.o");
+    args.push_back(crtDir + "/crtn.o");
+    return runLLD(args);
+#elif defined(SA_HAVE_LLD)
+    std::cerr << "Link Error: The C library was not found when sac was configured." << std::endl;
+    return false;
+#else
+    std::cerr << "Link Error: sac was built without lld; emit LLVM IR instead and link it as"
+              << " described in docs/pipeline.md." << std::endl;
+    return false;
+#endif
+}
+
+} // namespace sa
@@ -12,6 +12,7 @@ const char* getTokenName(TokenKind kind) {
         case eof: return "eof";
         case identifier: return "identifier";
         case string_literal: return "string_literal";
+        case integer_literal: return "integer_literal";
         case l_paren: return "l_paren";
         case r_paren: return "r_paren";
         case l_brace: return "l_brace";
@@ -20,9 +21,45 @@ const char* getTokenName(TokenKind kind) {
         case equal: return "equal";
         case arrow: return "arrow";
         case colon: return "colon";
+        case at: return "at";
+        case comma: return "comma";
+        case dot: return "dot";
+        case dotdot: return "dotdot";
+        case l_square: return "l_square";
+        case r_square: return "r_square";
+        case plus: return "plus";
+        case minus: return "minus";
+        case star: return "star";
+        case slash: return "slash";
+        case percent: return "percent";
+        case less: return "less";
+        case less_equal: return "less_equal";
+        case greater: return "greater";
+        case greater_equal: return "greater_equal";
+        case equal_equal: return "equal_equal";
+        case bang_equal: return "bang_equal";
         case kw_fn: return "kw_fn";
         case kw_let: return "kw_let";
         case kw_void: return "kw_void";
+        case kw_str: return "kw_str";
+        case kw_i64: return "kw_i64";
+        case kw_bool: return "kw_bool";
+        case kw_true: return "kw_true";
+        case kw_false: return "kw_false";
+        case kw_struct: return "kw_struct";
+        case kw_if: return "kw_if";
+        case kw_else: return "kw_else";
+        case kw_return: return "kw_return";
+        case kw_while: return "kw_while";
+        case kw_for: return "kw_for";
+        case kw_in: return "kw_in";
+        case kw_import: return "kw_import";
+        case kw_export: return "kw_export";
+        case kw_spawn: return "kw_spawn";
+        case kw_join: return "kw_join";
+        case kw_region: return "kw_region";
+        case kw_async: return "kw_async";
+        case kw_await: return "kw_await";
         default: return "unnamed_token";
     }
 }
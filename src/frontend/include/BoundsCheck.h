@@ -0,0 +1,33 @@
+//===--- BoundsCheck.h - Bounds-check Elimination ---------------*- C++ -*-===//
+//
+// This file declares eliminateBoundsChecks, a range analysis over the AST
+// that decides, before any code is generated, which array accesses need
+// their index checked against the array's length.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "ast/include/Decl.h"
+#include <memory>
+#include <vector>
+
+namespace sa {
+
+// Marks the IndexExprs in the bodies of 'ast' whose index is known to be in
+// range as not needing a check. That is the case for 'a[i]' in
+// 'for i in 0..a.len', or in 'for i in 0..N' over an array declared with at
+// least N elements, as long as the body assigns neither 'a' nor 'i'; and
+// for a constant index into such an array.
+//
+// Other accesses 'a[i]' that the body of 'for i in lo..hi' executes on
+// every iteration are instead covered by one check of the whole range
+// against the length of 'a' before the loop (ForStmt::getHoistedChecks).
+// A loop that would index out of range thus stops the program before its
+// first iteration rather than at the bad one.
+void eliminateBoundsChecks(std::vector<std::unique_ptr<Decl>>& ast);
+
+// The same for the body of one function.
+void eliminateBoundsChecks(FunctionDecl& fn);
+
+} // namespace sa
@@ -8,17 +8,27 @@
 #pragma once
 
 #include "core/include/Token.h"
+#include "frontend/include/TokenSource.h"
+#include <cstddef>
 #include <string_view>
 
 namespace sa {
 
-class Lexer {
+class Lexer : public TokenSource {
 public:
-    // Constructor: Initializes the lexer with the source code.
-    Lexer(std::string_view source);
+    // Constructor: Initializes the lexer with the source code. 'line' is the
+    // line number of the first character, for lexing part of a file.
+    Lexer(std::string_view source, unsigned int line = 1);
 
     // The main entry point for the lexer. Scans and returns the next token.
-    Token scanNextToken();
+    Token scanNextToken() override;
+
+    // True if the source ended inside a string literal. The last token
+    // before tok::eof was then an error token for it.
+    bool endedInString() const { return unterminatedString; }
+
+    // The offset of the unterminated literal's opening quote.
+    size_t getUnterminatedStringStart() const { return unterminatedStringStart; }
 
 private:
     // Advances the current position and returns the character that was consumed.
@@ -42,15 +52,18 @@ private:
 
     // Helper functions for scanning specific token types.
     Token scanStringLiteral();
+    Token scanIntegerLiteral();
     Token scanIdentifierOrKeyword();
 
     // Helper to skip over characters that are not part of tokens.
     void skipWhitespaceAndComments();
 
     std::string_view source; // The full source code text.
-    unsigned int start = 0;      // Start of the current lexeme being scanned.
-    unsigned int current = 0;    // Current character we are looking at.
+    size_t start = 0;            // Start of the current lexeme being scanned.
+    size_t current = 0;          // Current character we are looking at.
     unsigned int line = 1;       // Current line number for error reporting.
+    bool unterminatedString = false;
+    size_t unterminatedStringStart = 0;
 };
 
 } // namespace sa
\ No newline at end of file
@@ -0,0 +1,24 @@
+//===--- ParallelLexer.h - Multi-threaded Lexing of One File ----*- C++ -*-===//
+//
+// This file declares lexInParallel, which splits a large source file into
+// chunks at line boundaries and lexes the chunks on separate threads.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "frontend/include/TokenSource.h"
+#include <cstddef>
+#include <string_view>
+
+namespace sa {
+
+// Files smaller than this are not worth starting threads for.
+constexpr size_t ParallelLexThreshold = 16 * 1024 * 1024;
+
+// Lexes 'source' using up to 'numThreads' threads. The result replays
+// exactly the tokens, with the same lexemes and line numbers, that a single
+// Lexer over the whole of 'source' would produce.
+TokenBuffer lexInParallel(std::string_view source, unsigned numThreads);
+
+} // namespace sa
@@ -6,7 +6,7 @@
 #pragma once
 
 #include "core/include/Token.h"
-#include "frontend/include/Lexer.h"
+#include "frontend/include/TokenSource.h"
 #include "ast/include/Decl.h"
 #include "ast/include/Stmt.h"
 #include "ast/include/Expr.h"
@@ -17,17 +17,39 @@ namespace sa {
 
 class Parser {
 public:
-    // Constructor: Initializes the parser with a lexer.
-    Parser(Lexer& lexer);
+    // Constructor: Initializes the parser with a token source, usually a
+    // Lexer over the whole file.
+    Parser(TokenSource& lexer);
 
     // The main entry point. Parses the entire source file and returns the
     // root of the AST (a list of all top-level declarations).
     std::vector<std::unique_ptr<Decl>> parse();
 
+    // In skim mode function bodies are only brace-matched, not parsed; see
+    // FunctionDecl::isSkimmed. parseReachableBodies parses them later.
+    void setSkimFunctionBodies(bool skim) { skimFunctionBodies = skim; }
+
+    // Parses a braced function body, e.g. the text of a skimmed one.
+    std::vector<std::unique_ptr<Stmt>> parseFunctionBody();
+
+    // The type parameters a body parsed on its own may use as types: those
+    // of the function it belongs to.
+    void setTypeParams(std::vector<Token> params) { typeParams = std::move(params); }
+
 private:
-    Lexer& lexer;
+    TokenSource& lexer;
     Token currentToken;
     Token previousToken;
+    bool skimFunctionBodies = false;
+
+    // The type parameters of the function being parsed, which its
+    // signature and body may use as types.
+    std::vector<Token> typeParams;
+
+    // Set while parsing an 'if' or 'while' condition or a 'for' range, where
+    // 'name {' starts the block rather than a struct literal. Parentheses
+    // allow them again.
+    bool noStructLiterals = false;
 
     // --- Core Parsing Primitives ---
     // Advances the token stream.
@@ -41,13 +63,47 @@ private:
 
     // --- Grammar Rule Parsing Methods ---
     std::unique_ptr<Decl> parseTopLevelDecl();
+    std::unique_ptr<ImportDecl> parseImportDecl();
+    // Everything that can be written in front of 'fn' or 'struct'.
+    struct Annotations {
+        unsigned attrs = FA_None;
+        std::vector<std::string_view> targetClones;
+        unsigned structAttrs = SA_None;
+        uint64_t align = 0;
+    };
+    Annotations parseAnnotations();
     std::unique_ptr<FunctionDecl> parseFunctionDefinition();
+    std::unique_ptr<StructDecl> parseStructDecl();
+    std::unique_ptr<FunctionDecl> skimFunctionBody(const Token& name, std::vector<Param> params);
+    Type parseType();
+    // Parses an integer literal that must be a positive constant, like an
+    // array length.
+    uint64_t parseConstant(const char* what);
     std::unique_ptr<Stmt> parseStatement();
     std::unique_ptr<DeclStmt> parseVarDeclStatement();
-    std::unique_ptr<ExprStmt> parseExprStatement();
+    // An expression statement or an assignment.
+    std::unique_ptr<Stmt> parseExprStatement();
+    std::unique_ptr<SpawnStmt> parseSpawnStatement();
+    std::unique_ptr<RegionStmt> parseRegionStatement();
+    std::unique_ptr<IfStmt> parseIfStatement();
+    std::unique_ptr<WhileStmt> parseWhileStatement();
+    std::unique_ptr<ForStmt> parseForStatement();
+    // Parses an expression followed by a '{', like an 'if' condition.
+    std::unique_ptr<Expr> parseHeaderExpression();
+    // Parses statements up to and including the '}' closing a block.
+    std::vector<std::unique_ptr<Stmt>> parseBlockStatements();
 
     std::unique_ptr<Expr> parseExpression();
+    std::unique_ptr<Expr> parseComparison();
+    std::unique_ptr<Expr> parseAdditive();
+    std::unique_ptr<Expr> parseMultiplicative();
+    // Field accesses and indexing: 'a.b[i]'.
+    std::unique_ptr<Expr> parsePostfixExpression();
     std::unique_ptr<Expr> parsePrimaryExpression();
+    // Parses an expression inside brackets of some kind, where struct
+    // literals are always allowed.
+    std::unique_ptr<Expr> parseNestedExpression();
+    std::unique_ptr<StructLiteralExpr> parseStructLiteral(const Token& name);
 };
 
 } // namespace sa
\ No newline at end of file
@@ -0,0 +1,24 @@
+//===--- Reachability.h - Reachability-driven Body Parsing ------*- C++ -*-===//
+//
+// This file declares parseReachableBodies, the second half of lazy parsing:
+// after the parser skimmed all function bodies, only the bodies that can
+// actually run are parsed.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "ast/include/Decl.h"
+#include <memory>
+#include <vector>
+
+namespace sa {
+
+// Walks the call graph recorded while skimming, starting at 'main' and at
+// every exported function. Parses the skimmed bodies of the functions it
+// reaches and removes all other functions from 'ast', so that they are
+// never lowered either. Callees are found by name, which over-approximates
+// the real call graph and therefore never drops a function that is used.
+void parseReachableBodies(std::vector<std::unique_ptr<Decl>>& ast);
+
+} // namespace sa
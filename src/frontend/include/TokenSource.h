@@ -0,0 +1,50 @@
+//===--- TokenSource.h - Token Streams for the 'sa' Parser ------*- C++ -*-===//
+//
+// This file defines the TokenSource interface the parser reads tokens from,
+// and TokenBuffer, a source that replays tokens lexed ahead of time.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "core/include/Token.h"
+#include <vector>
+
+namespace sa {
+
+// Anything that produces tokens one at a time, ending with tok::eof.
+class TokenSource {
+public:
+    virtual ~TokenSource() = default;
+
+    // Returns the next token. Keeps returning tok::eof once exhausted.
+    virtual Token scanNextToken() = 0;
+};
+
+// Replays a token sequence that is stored as consecutive segments, so that
+// separately lexed parts of a file can be handed over without copying them
+// into one vector.
+class TokenBuffer : public TokenSource {
+public:
+    TokenBuffer(std::vector<std::vector<Token>> segments, Token eof)
+        : Segments(std::move(segments)), Eof(eof) {}
+
+    Token scanNextToken() override {
+        while (Segment < Segments.size()) {
+            if (Index < Segments[Segment].size()) {
+                return Segments[Segment][Index++];
+            }
+            ++Segment;
+            Index = 0;
+        }
+        return Eof;
+    }
+
+private:
+    std::vector<std::vector<Token>> Segments;
+    Token Eof;
+    size_t Segment = 0;
+    size_t Index = 0;
+};
+
+} // namespace sa
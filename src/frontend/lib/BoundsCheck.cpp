@@ -0,0 +1,292 @@
+//===--- BoundsCheck.cpp - Bounds-check Elimination -------------*- C++ -*-===//
+//
+// This file implements eliminateBoundsChecks.
+//
+// The analysis is purely syntactic: it does not know the types of
+// expressions, only what the source says about the names involved. That is
+// enough for the loops indexed code is usually written with, and anything
+// it cannot prove keeps its check.
+//
+//===----------------------------------------------------------------------===//
+
+#include "frontend/include/BoundsCheck.h"
+#include "ast/include/Expr.h"
+#include "ast/include/Stmt.h"
+#include "ast/include/Visitor.h"
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+
+namespace sa {
+
+namespace {
+
+// The value of an integer literal, if it fits.
+std::optional<uint64_t> getConstant(const IntegerLiteralExpr& literal) {
+    uint64_t value = 0;
+    for (char digit : literal.getLexeme()) {
+        if (value > (UINT64_MAX - (digit - '0')) / 10) {
+            return std::nullopt;
+        }
+        value = value * 10 + (digit - '0');
+    }
+    return value;
+}
+
+// What the analysis knows about an enclosing 'for i in lo..hi' loop.
+struct Loop {
+    explicit Loop(ForStmt* stmt) : Stmt(stmt) {}
+
+    ForStmt* Stmt;
+
+    // Set if 'lo' cannot be negative.
+    bool LoNonNegative = false;
+    // 'hi' if it is a constant.
+    std::optional<uint64_t> HiConstant;
+    // 'a' if 'hi' is 'a.len'.
+    std::string_view HiLengthOf;
+
+    // The names the body declares or assigns, anywhere in it. Facts about
+    // those names do not hold inside the loop.
+    std::set<std::string_view> Modified;
+    // Set if the body can return, so that its statements may not run on
+    // every iteration.
+    bool Returns = false;
+
+    // The ConditionalDepth of the statements directly in the body.
+    unsigned BodyDepth = 0;
+};
+
+// Collects what 'body' can change into 'loop'.
+void scanBody(const std::vector<std::unique_ptr<Stmt>>& body, Loop& loop) {
+    for (const auto& stmt : body) {
+        if (auto* decl = dynamic_cast<DeclStmt*>(stmt.get())) {
+            loop.Modified.insert(decl->getDecl()->getName());
+        } else if (auto* assign = dynamic_cast<AssignStmt*>(stmt.get())) {
+            // Assigning to an element or field leaves the length alone.
+            if (auto* var = dynamic_cast<VariableExpr*>(assign->getTarget())) {
+                loop.Modified.insert(var->getName());
+            }
+        } else if (auto* ifStmt = dynamic_cast<IfStmt*>(stmt.get())) {
+            scanBody(ifStmt->getThen(), loop);
+            scanBody(ifStmt->getElse(), loop);
+        } else if (auto* whileStmt = dynamic_cast<WhileStmt*>(stmt.get())) {
+            scanBody(whileStmt->getBody(), loop);
+        } else if (auto* forStmt = dynamic_cast<ForStmt*>(stmt.get())) {
+            loop.Modified.insert(forStmt->getVar());
+            scanBody(forStmt->getBody(), loop);
+        } else if (auto* region = dynamic_cast<RegionStmt*>(stmt.get())) {
+            scanBody(region->getBody(), loop);
+        } else if (dynamic_cast<ReturnStmt*>(stmt.get())) {
+            loop.Returns = true;
+        }
+    }
+}
+
+class RangeAnalysis : public Visitor {
+public:
+    void run(FunctionDecl& fn) {
+        ArrayLengths.clear();
+        for (const Param& param : fn.getParams()) {
+            if (param.Ty.isArray()) {
+                ArrayLengths[param.Name.lexeme] = param.Ty.getLength();
+            }
+        }
+        visitBlock(fn.getBody());
+    }
+
+private:
+    // The lengths of the variables in scope that are declared as arrays.
+    std::map<std::string_view, uint64_t> ArrayLengths;
+
+    // The 'for' loops around the current statement, innermost last.
+    std::vector<Loop> Loops;
+
+    // How many blocks that may not run (once per iteration) the current
+    // statement is nested in.
+    unsigned ConditionalDepth = 0;
+
+    void visitBlock(const std::vector<std::unique_ptr<Stmt>>& stmts) {
+        auto outerLengths = ArrayLengths;
+        for (const auto& stmt : stmts) {
+            stmt->accept(*this);
+        }
+        ArrayLengths = std::move(outerLengths);
+    }
+
+    void visitConditionalBlock(const std::vector<std::unique_ptr<Stmt>>& stmts) {
+        ++ConditionalDepth;
+        visitBlock(stmts);
+        --ConditionalDepth;
+    }
+
+    // Function bodies contain no other declarations.
+    void visit(FunctionDecl& decl) override {}
+    void visit(ImportDecl& decl) override {}
+    void visit(StructDecl& decl) override {}
+
+    void visit(VarDecl& decl) override {
+        if (decl.getInitializer()) {
+            decl.getInitializer()->accept(*this);
+        }
+        if (decl.getDeclaredType().isArray()) {
+            ArrayLengths[decl.getName()] = decl.getDeclaredType().getLength();
+        } else {
+            ArrayLengths.erase(decl.getName());
+        }
+    }
+
+    void visit(DeclStmt& stmt) override { stmt.getDecl()->accept(*this); }
+    void visit(ExprStmt& stmt) override { stmt.getExpr()->accept(*this); }
+    void visit(SpawnStmt& stmt) override { stmt.getCall()->accept(*this); }
+    void visit(JoinStmt& stmt) override {}
+    void visit(RegionStmt& stmt) override { visitBlock(stmt.getBody()); }
+
+    void visit(ReturnStmt& stmt) override {
+        if (stmt.getValue()) {
+            stmt.getValue()->accept(*this);
+        }
+    }
+
+    void visit(IfStmt& stmt) override {
+        stmt.getCond()->accept(*this);
+        visitConditionalBlock(stmt.getThen());
+        visitConditionalBlock(stmt.getElse());
+    }
+
+    void visit(AssignStmt& stmt) override {
+        stmt.getValue()->accept(*this);
+        stmt.getTarget()->accept(*this);
+    }
+
+    void visit(WhileStmt& stmt) override {
+        stmt.getCond()->accept(*this);
+        visitConditionalBlock(stmt.getBody());
+    }
+
+    void visit(ForStmt& stmt) override {
+        stmt.getLo()->accept(*this);
+        stmt.getHi()->accept(*this);
+
+        Loop loop(&stmt);
+        // Literals are never negative; there is no unary minus.
+        loop.LoNonNegative = dynamic_cast<IntegerLiteralExpr*>(stmt.getLo()) != nullptr;
+        if (auto* hi = dynamic_cast<IntegerLiteralExpr*>(stmt.getHi())) {
+            loop.HiConstant = getConstant(*hi);
+        } else if (auto* hi = dynamic_cast<FieldExpr*>(stmt.getHi())) {
+            auto* array = dynamic_cast<VariableExpr*>(hi->getBase());
+            if (array && hi->getName() == "len") {
+                loop.HiLengthOf = array->getName();
+            }
+        }
+        scanBody(stmt.getBody(), loop);
+
+        // The body does not run at all if the range is empty.
+        ++ConditionalDepth;
+        loop.BodyDepth = ConditionalDepth;
+        Loops.push_back(std::move(loop));
+
+        auto outerLengths = ArrayLengths;
+        ArrayLengths.erase(stmt.getVar());
+        visitBlock(stmt.getBody());
+        ArrayLengths = std::move(outerLengths);
+
+        Loops.pop_back();
+        --ConditionalDepth;
+    }
+
+    void visit(IndexExpr& expr) override {
+        expr.getBase()->accept(*this);
+        expr.getIndex()->accept(*this);
+
+        auto* array = dynamic_cast<VariableExpr*>(expr.getBase());
+        if (!array) {
+            return;
+        }
+        auto length = ArrayLengths.find(array->getName());
+
+        if (auto* constant = dynamic_cast<IntegerLiteralExpr*>(expr.getIndex())) {
+            std::optional<uint64_t> value = getConstant(*constant);
+            if (value && length != ArrayLengths.end() && *value < length->second) {
+                expr.setBoundsCheck(BoundsCheck::Proven);
+            }
+            return;
+        }
+
+        auto* index = dynamic_cast<VariableExpr*>(expr.getIndex());
+        if (!index) {
+            return;
+        }
+        for (size_t i = Loops.size(); i-- > 0;) {
+            Loop& loop = Loops[i];
+            if (loop.Stmt->getVar() != index->getName()) {
+                continue;
+            }
+            if (loop.Modified.count(index->getName()) || loop.Modified.count(array->getName())) {
+                return;
+            }
+
+            bool fits = loop.HiLengthOf == array->getName() ||
+                        (loop.HiConstant && length != ArrayLengths.end() &&
+                         *loop.HiConstant <= length->second);
+            if (loop.LoNonNegative && fits) {
+                expr.setBoundsCheck(BoundsCheck::Proven);
+            } else if (ConditionalDepth == loop.BodyDepth && !loop.Returns) {
+                loop.Stmt->addHoistedCheck(array->getName());
+                expr.setBoundsCheck(BoundsCheck::Hoisted);
+            }
+            return;
+        }
+    }
+
+    void visit(SliceExpr& expr) override {
+        expr.getBase()->accept(*this);
+        expr.getLo()->accept(*this);
+        expr.getHi()->accept(*this);
+    }
+
+    void visit(FieldExpr& expr) override { expr.getBase()->accept(*this); }
+
+    void visit(StructLiteralExpr& expr) override {
+        for (const auto& field : expr.getFields()) {
+            field.second->accept(*this);
+        }
+    }
+
+    void visit(CallExpr& expr) override {
+        for (const auto& arg : expr.getArgs()) {
+            arg->accept(*this);
+        }
+    }
+
+    void visit(AwaitExpr& expr) override { expr.getCall()->accept(*this); }
+
+    void visit(BinaryExpr& expr) override {
+        expr.getLHS()->accept(*this);
+        expr.getRHS()->accept(*this);
+    }
+
+    void visit(StringLiteralExpr& expr) override {}
+    void visit(IntegerLiteralExpr& expr) override {}
+    void visit(BoolLiteralExpr& expr) override {}
+    void visit(VariableExpr& expr) override {}
+};
+
+} // namespace
+
+void eliminateBoundsChecks(std::vector<std::unique_ptr<Decl>>& ast) {
+    RangeAnalysis analysis;
+    for (const auto& decl : ast) {
+        if (auto* fn = dynamic_cast<FunctionDecl*>(decl.get())) {
+            analysis.run(*fn);
+        }
+    }
+}
+
+void eliminateBoundsChecks(FunctionDecl& fn) {
+    RangeAnalysis analysis;
+    analysis.run(fn);
+}
+
+} // namespace sa
@@ -15,9 +15,28 @@ static const std::unordered_map<std::string_view, tok::TokenKind> KeywordMap = {
     {"fn",   tok::kw_fn},
     {"let",  tok::kw_let},
     {"void", tok::kw_void},
+    {"str",  tok::kw_str},
+    {"i64",  tok::kw_i64},
+    {"bool", tok::kw_bool},
+    {"true", tok::kw_true},
+    {"false", tok::kw_false},
+    {"struct", tok::kw_struct},
+    {"if", tok::kw_if},
+    {"else", tok::kw_else},
+    {"return", tok::kw_return},
+    {"while", tok::kw_while},
+    {"for", tok::kw_for},
+    {"in", tok::kw_in},
+    {"import", tok::kw_import},
+    {"export", tok::kw_export},
+    {"spawn", tok::kw_spawn},
+    {"join", tok::kw_join},
+    {"region", tok::kw_region},
+    {"async", tok::kw_async},
+    {"await", tok::kw_await},
 };
 
-Lexer::Lexer(std::string_view source) : source(source) {}
+Lexer::Lexer(std::string_view source, unsigned int line) : source(source), line(line) {}
 
 Token Lexer::scanNextToken() {
     skipWhitespaceAndComments();
@@ -40,6 +59,11 @@ Token Lexer::scanNextToken() {
         return scanStringLiteral();
     }
 
+    // Check for integer literals
+    if (isdigit(c)) {
+        return scanIntegerLiteral();
+    }
+
     // This is our main dispatcher.
     switch (c) {
         case '(': return makeToken(tok::l_paren);
@@ -47,13 +71,25 @@ Token Lexer::scanNextToken() {
         case '{': return makeToken(tok::l_brace);
         case '}': return makeToken(tok::r_brace);
         case ';': return makeToken(tok::semicolon);
-        case '=': return makeToken(tok::equal);
+        case '=': return makeToken(match('=') ? tok::equal_equal : tok::equal);
         case ':': return makeToken(tok::colon);
-        case '-':
-            if (match('>')) {
-                return makeToken(tok::arrow);
+        case '@': return makeToken(tok::at);
+        case ',': return makeToken(tok::comma);
+        case '.': return makeToken(match('.') ? tok::dotdot : tok::dot);
+        case '[': return makeToken(tok::l_square);
+        case ']': return makeToken(tok::r_square);
+        case '-': return makeToken(match('>') ? tok::arrow : tok::minus);
+        case '+': return makeToken(tok::plus);
+        case '*': return makeToken(tok::star);
+        case '/': return makeToken(tok::slash);
+        case '%': return makeToken(tok::percent);
+        case '<': return makeToken(match('=') ? tok::less_equal : tok::less);
+        case '>': return makeToken(match('=') ? tok::greater_equal : tok::greater);
+        case '!':
+            if (match('=')) {
+                return makeToken(tok::bang_equal);
             }
-            break; // We would handle 'minus' here in the future.
+            break;
     }
 
     return makeErrorToken("Unexpected character.");
@@ -140,6 +176,13 @@ Token Lexer::scanIdentifierOrKeyword() {
     return makeToken(tok::identifier);
 }
 
+Token Lexer::scanIntegerLiteral() {
+    while (isdigit(peek())) {
+        advance();
+    }
+    return makeToken(tok::integer_literal);
+}
+
 Token Lexer::scanStringLiteral() {
     while (peek() != '"' && !isAtEnd()) {
         if (peek() == '\n') line++;
@@ -147,6 +190,8 @@ Token Lexer::scanStringLiteral() {
     }
 
     if (isAtEnd()) {
+        unterminatedString = true;
+        unterminatedStringStart = start;
         return makeErrorToken("Unterminated string.");
     }
 
@@ -0,0 +1,125 @@
+//===--- ParallelLexer.cpp - Multi-threaded Lexing of One File --*- C++ -*-===//
+//
+// This file implements lexInParallel.
+//
+// Chunks always start right after a newline. No token can span a line
+// except a string literal, so a chunk can be lexed on its own as long as it
+// does not start inside one. That is assumed speculatively; afterwards the
+// chunks are stitched together in order, and wherever a chunk ended inside
+// a string literal the literal is lexed again serially from its opening
+// quote, up to the first chunk boundary after it closes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "frontend/include/ParallelLexer.h"
+#include "frontend/include/Lexer.h"
+#include <algorithm>
+#include <thread>
+
+namespace sa {
+
+namespace {
+
+// The tokens of source[begin, end), lexed as if 'begin' was outside of any
+// token. If the range ended inside a string literal, the last token is the
+// error token for it.
+struct LexedRange {
+    std::vector<Token> Tokens;
+    bool EndedInString = false;
+    size_t StringStart = 0;     // Offset of the literal's opening quote.
+    unsigned int StringLine = 0; // Line of the literal's opening quote.
+};
+
+LexedRange lexRange(std::string_view source, size_t begin, size_t end, unsigned int line) {
+    LexedRange range;
+    Lexer lexer(source.substr(begin, end - begin), line);
+    for (Token token = lexer.scanNextToken(); token.kind != tok::eof; token = lexer.scanNextToken()) {
+        range.Tokens.push_back(token);
+    }
+
+    if (lexer.endedInString()) {
+        range.EndedInString = true;
+        range.StringStart = begin + lexer.getUnterminatedStringStart();
+        // The error token carries the line the literal ran off the end on.
+        range.StringLine = range.Tokens.back().line -
+            std::count(source.begin() + range.StringStart, source.begin() + end, '\n');
+    }
+    return range;
+}
+
+// Runs work(0) .. work(count - 1), each on its own thread.
+template <typename Fn>
+void forEachInParallel(size_t count, Fn work) {
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < count; ++i) {
+        threads.emplace_back(work, i);
+    }
+    work(0);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace
+
+TokenBuffer lexInParallel(std::string_view source, unsigned numThreads) {
+    // Split at the first newline after each of the evenly spaced points.
+    std::vector<size_t> bounds = {0};
+    size_t target = std::max<size_t>(source.size() / std::max(numThreads, 1u), 1);
+    for (unsigned i = 1; i < numThreads; ++i) {
+        size_t newline = source.find('\n', std::max(bounds.back(), i * target));
+        if (newline == std::string_view::npos || newline + 1 >= source.size()) {
+            break;
+        }
+        bounds.push_back(newline + 1);
+    }
+    bounds.push_back(source.size());
+    size_t numChunks = bounds.size() - 1;
+
+    // Pre-scan: every newline increments the line count exactly once, in or
+    // out of a literal, so the first line of each chunk follows from a plain
+    // count, which is far cheaper than lexing.
+    std::vector<unsigned int> newlines(numChunks);
+    forEachInParallel(numChunks, [&](size_t i) {
+        newlines[i] = std::count(source.begin() + bounds[i], source.begin() + bounds[i + 1], '\n');
+    });
+    std::vector<unsigned int> firstLine(numChunks, 1);
+    for (size_t i = 1; i < numChunks; ++i) {
+        firstLine[i] = firstLine[i - 1] + newlines[i - 1];
+    }
+
+    std::vector<LexedRange> chunks(numChunks);
+    forEachInParallel(numChunks, [&](size_t i) {
+        chunks[i] = lexRange(source, bounds[i], bounds[i + 1], firstLine[i]);
+    });
+
+    // Stitch. 'range' always starts outside of a literal and covers the
+    // source up to bounds[end].
+    std::vector<std::vector<Token>> segments;
+    for (size_t i = 0; i < numChunks;) {
+        LexedRange range = std::move(chunks[i]);
+        size_t end = i + 1;
+
+        while (range.EndedInString && end < numChunks) {
+            size_t from = range.StringStart;
+            unsigned int line = range.StringLine;
+            range.Tokens.pop_back();
+            segments.push_back(std::move(range.Tokens));
+
+            // Literals have no escapes, so the next quote closes this one.
+            size_t close = source.find('"', from + 1);
+            while (end < numChunks && (close == std::string_view::npos || bounds[end] <= close)) {
+                ++end;
+            }
+            range = lexRange(source, from, bounds[end], line);
+        }
+
+        segments.push_back(std::move(range.Tokens));
+        i = end;
+    }
+
+    Token eof{tok::eof, source.substr(source.size()), firstLine.back() + newlines.back()};
+    return TokenBuffer(std::move(segments), eof);
+}
+
+} // namespace sa
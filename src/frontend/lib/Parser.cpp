@@ -5,11 +5,31 @@
 //===----------------------------------------------------------------------===//
 
 #include "frontend/include/Parser.h"
+#include <cstdint>
 #include <iostream>
+#include <unordered_map>
 
 namespace sa {
 
-Parser::Parser(Lexer& lexer) : lexer(lexer) {
+// The annotations accepted in front of a function, e.g. '@cold fn fail() ...'.
+static const std::unordered_map<std::string_view, FunctionAttr> FunctionAnnotationMap = {
+    {"inline",   FA_Inline},
+    {"noinline", FA_NoInline},
+    {"hot",      FA_Hot},
+    {"cold",     FA_Cold},
+    {"pure",     FA_Pure},
+};
+
+// The annotations accepted in front of a struct, e.g. '@packed struct ...'.
+static const std::unordered_map<std::string_view, StructAttr> StructAnnotationMap = {
+    {"packed", SA_Packed},
+    {"soa",    SA_SoA},
+};
+
+// The largest alignment '@align(N)' accepts: a page.
+static constexpr uint64_t MaxStructAlign = 4096;
+
+Parser::Parser(TokenSource& lexer) : lexer(lexer) {
     // Prime the parser with the first token.
     advance();
 }
@@ -58,21 +78,307 @@ bool Parser::isAtEnd() const {
 // --- Grammar Rule Implementations ---
 
 std::unique_ptr<Decl> Parser::parseTopLevelDecl() {
+    if (match(tok::kw_import)) {
+        return parseImportDecl();
+    }
+
+    Annotations annotations = parseAnnotations();
+    bool hasFunctionAnnotations = annotations.attrs != FA_None || !annotations.targetClones.empty();
+    bool hasStructAnnotations = annotations.structAttrs != SA_None || annotations.align != 0;
+
+    if (match(tok::kw_struct)) {
+        if (hasFunctionAnnotations) {
+            std::cerr << "Parse Error on line " << previousToken.line
+                      << ": Function annotations cannot be applied to a struct." << std::endl;
+            exit(1);
+        }
+        auto decl = parseStructDecl();
+        decl->setAttrs(annotations.structAttrs);
+        decl->setAlign(annotations.align);
+        return decl;
+    }
+
+    bool isExported = match(tok::kw_export);
+    bool isAsync = match(tok::kw_async);
+    if (isAsync && currentToken.kind != tok::kw_fn) {
+        std::cerr << "Parse Error on line " << previousToken.line << ": Expected 'fn' after 'async'."
+                  << std::endl;
+        exit(1);
+    }
     if (match(tok::kw_fn)) {
-        return parseFunctionDefinition();
+        if (hasStructAnnotations) {
+            std::cerr << "Parse Error on line " << previousToken.line
+                      << ": '@packed', '@align' and '@soa' only apply to structs." << std::endl;
+            exit(1);
+        }
+        auto fn = parseFunctionDefinition();
+        if (isExported && isAsync) {
+            std::cerr << "Parse Error on line " << previousToken.line << ": Async function '"
+                      << fn->getName() << "' cannot be exported yet." << std::endl;
+            exit(1);
+        }
+        if (isExported && fn->isGeneric()) {
+            std::cerr << "Parse Error on line " << previousToken.line << ": Generic function '"
+                      << fn->getName() << "' cannot be exported yet." << std::endl;
+            exit(1);
+        }
+        if (isExported) {
+            bool aggregate = fn->getReturnType().isAggregate();
+            for (const Param& param : fn->getParams()) {
+                aggregate |= param.Ty.isAggregate();
+            }
+            if (aggregate) {
+                std::cerr << "Parse Error on line " << previousToken.line << ": Function '"
+                          << fn->getName() << "' takes or returns a struct, array or slice and cannot be"
+                          << " exported yet." << std::endl;
+                exit(1);
+            }
+        }
+        fn->setExported(isExported);
+        fn->setAsync(isAsync);
+        fn->setAttrs(annotations.attrs);
+        fn->setTargetClones(std::move(annotations.targetClones));
+        return fn;
+    }
+    if (isExported || hasFunctionAnnotations) {
+        std::cerr << "Parse Error on line " << previousToken.line << ": Expected 'fn' after '"
+                  << previousToken.lexeme << "'." << std::endl;
+        exit(1);
     }
-    // In the future, we could parse 'struct', 'import', etc. here.
-    std::cerr << "Parse Error: Expected a top-level declaration (like 'fn')." << std::endl;
+    if (hasStructAnnotations) {
+        std::cerr << "Parse Error on line " << previousToken.line << ": Expected 'struct' after '"
+                  << previousToken.lexeme << "'." << std::endl;
+        exit(1);
+    }
+    std::cerr << "Parse Error: Expected a top-level declaration (like 'fn' or 'struct')." << std::endl;
     exit(1);
 }
 
+std::unique_ptr<ImportDecl> Parser::parseImportDecl() {
+    Token name = currentToken;
+    consume(tok::identifier, "Expected module name after 'import'.");
+    consume(tok::semicolon, "Expected ';' after import declaration.");
+    return std::make_unique<ImportDecl>(name);
+}
+
+Parser::Annotations Parser::parseAnnotations() {
+    Annotations annotations;
+    unsigned& attrs = annotations.attrs;
+    unsigned& structAttrs = annotations.structAttrs;
+    while (match(tok::at)) {
+        Token name = currentToken;
+        consume(tok::identifier, "Expected annotation name after '@'.");
+
+        // '@target_clones("avx2", "default")' is the only annotation with
+        // arguments.
+        if (name.lexeme == "target_clones") {
+            consume(tok::l_paren, "Expected '(' after '@target_clones'.");
+            do {
+                Token target = currentToken;
+                consume(tok::string_literal, "Expected an instruction set name like \"avx2\".");
+                annotations.targetClones.push_back(target.lexeme.substr(1, target.lexeme.size() - 2));
+            } while (match(tok::comma));
+            consume(tok::r_paren, "Expected ')' after '@target_clones' arguments.");
+            continue;
+        }
+
+        // '@align(64)' on a struct.
+        if (name.lexeme == "align") {
+            consume(tok::l_paren, "Expected '(' after '@align'.");
+            uint64_t align = parseConstant("The alignment");
+            if ((align & (align - 1)) != 0 || align > MaxStructAlign) {
+                std::cerr << "Parse Error on line " << previousToken.line << ": The alignment must be a"
+                          << " power of two no larger than " << MaxStructAlign << "." << std::endl;
+                exit(1);
+            }
+            consume(tok::r_paren, "Expected ')' after the alignment.");
+            annotations.align = align;
+            continue;
+        }
+
+        auto structIt = StructAnnotationMap.find(name.lexeme);
+        if (structIt != StructAnnotationMap.end()) {
+            structAttrs |= structIt->second;
+            continue;
+        }
+
+        auto it = FunctionAnnotationMap.find(name.lexeme);
+        if (it == FunctionAnnotationMap.end()) {
+            std::cerr << "Parse Error on line " << name.line << ": Unknown annotation '@" << name.lexeme << "'." << std::endl;
+            exit(1);
+        }
+        attrs |= it->second;
+    }
+
+    if ((attrs & FA_Inline) && (attrs & FA_NoInline)) {
+        std::cerr << "Parse Error on line " << previousToken.line << ": '@inline' and '@noinline' cannot be combined." << std::endl;
+        exit(1);
+    }
+    if ((attrs & FA_Hot) && (attrs & FA_Cold)) {
+        std::cerr << "Parse Error on line " << previousToken.line << ": '@hot' and '@cold' cannot be combined." << std::endl;
+        exit(1);
+    }
+    if ((structAttrs & SA_Packed) && annotations.align != 0) {
+        std::cerr << "Parse Error on line " << previousToken.line << ": '@packed' and '@align' cannot be combined." << std::endl;
+        exit(1);
+    }
+    if ((structAttrs & SA_SoA) && ((structAttrs & SA_Packed) || annotations.align != 0)) {
+        std::cerr << "Parse Error on line " << previousToken.line << ": '@soa' cannot be combined with '@packed' or '@align'." << std::endl;
+        exit(1);
+    }
+    return annotations;
+}
+
+std::unique_ptr<StructDecl> Parser::parseStructDecl() {
+    Token name = currentToken;
+    consume(tok::identifier, "Expected struct name.");
+    consume(tok::l_brace, "Expected '{' after struct name.");
+
+    // Field types are never generic.
+    typeParams.clear();
+
+    std::vector<Field> fields;
+    while (currentToken.kind != tok::r_brace && !isAtEnd()) {
+        Token fieldName = currentToken;
+        consume(tok::identifier, "Expected field name.");
+        consume(tok::colon, "Expected ':' after field name.");
+        Type fieldType = parseType();
+        if (fieldType.isVoid()) {
+            std::cerr << "Parse Error on line " << fieldName.line << ": Field '"
+                      << fieldName.lexeme << "' cannot have type 'void'." << std::endl;
+            exit(1);
+        }
+        for (const Field& field : fields) {
+            if (field.Name.lexeme == fieldName.lexeme) {
+                std::cerr << "Parse Error on line " << fieldName.line << ": Duplicate field '"
+                          << fieldName.lexeme << "' in struct '" << name.lexeme << "'." << std::endl;
+                exit(1);
+            }
+        }
+        fields.push_back({fieldName, fieldType});
+        if (!match(tok::comma)) {
+            break;
+        }
+    }
+
+    consume(tok::r_brace, "Expected '}' after struct fields.");
+    return std::make_unique<StructDecl>(name, std::move(fields));
+}
+
 std::unique_ptr<FunctionDecl> Parser::parseFunctionDefinition() {
     Token name = currentToken;
     consume(tok::identifier, "Expected function name.");
+
+    typeParams.clear();
+    if (match(tok::less)) {
+        do {
+            Token typeParam = currentToken;
+            consume(tok::identifier, "Expected type parameter name.");
+            typeParams.push_back(typeParam);
+        } while (match(tok::comma));
+        consume(tok::greater, "Expected '>' after type parameters.");
+    }
+
     consume(tok::l_paren, "Expected '(' after function name.");
+
+    std::vector<Param> params;
+    if (currentToken.kind != tok::r_paren) {
+        do {
+            Token paramName = currentToken;
+            consume(tok::identifier, "Expected parameter name.");
+            consume(tok::colon, "Expected ':' after parameter name.");
+            Type paramType = parseType();
+            if (paramType.isVoid()) {
+                std::cerr << "Parse Error on line " << paramName.line << ": Parameter '"
+                          << paramName.lexeme << "' cannot have type 'void'." << std::endl;
+                exit(1);
+            }
+            params.push_back({paramName, paramType});
+        } while (match(tok::comma));
+    }
+
     consume(tok::r_paren, "Expected ')' after parameters.");
     consume(tok::arrow, "Expected '->' for return type.");
-    consume(tok::kw_void, "Expected 'void' as return type for now.");
+    Type returnType = parseType();
+
+    std::unique_ptr<FunctionDecl> fn;
+    if (skimFunctionBodies) {
+        fn = skimFunctionBody(name, std::move(params));
+    } else {
+        fn = std::make_unique<FunctionDecl>(name, std::move(params), parseFunctionBody());
+    }
+    fn->setReturnType(returnType);
+    fn->setTypeParams(std::move(typeParams));
+    return fn;
+}
+
+Type Parser::parseType() {
+    if (match(tok::kw_void)) {
+        return TypeKind::Void;
+    }
+    if (match(tok::kw_str)) {
+        return TypeKind::Str;
+    }
+    if (match(tok::kw_i64)) {
+        return TypeKind::I64;
+    }
+    if (match(tok::kw_bool)) {
+        return TypeKind::Bool;
+    }
+    if (match(tok::identifier)) {
+        for (const Token& typeParam : typeParams) {
+            if (typeParam.lexeme == previousToken.lexeme) {
+                return Type::getParam(typeParam.lexeme);
+            }
+        }
+        // Structs may be declared further down, so the name is only
+        // checked when generating code.
+        return Type::getStruct(previousToken.lexeme);
+    }
+    if (match(tok::l_square)) {
+        if (match(tok::r_square)) {
+            Type element = parseType();
+            if (element.isVoid()) {
+                std::cerr << "Parse Error on line " << previousToken.line
+                          << ": Slices cannot hold 'void'." << std::endl;
+                exit(1);
+            }
+            return Type::getSlice(std::move(element));
+        }
+        Type element = parseType();
+        if (element.isVoid()) {
+            std::cerr << "Parse Error on line " << previousToken.line
+                      << ": Arrays cannot hold 'void'." << std::endl;
+            exit(1);
+        }
+        consume(tok::semicolon, "Expected ';' after the array element type.");
+        uint64_t length = parseConstant("The array length");
+        consume(tok::r_square, "Expected ']' after the array length.");
+        return Type::getArray(std::move(element), length);
+    }
+    std::cerr << "Parse Error on line " << currentToken.line << ": Expected a type." << std::endl;
+    exit(1);
+}
+
+uint64_t Parser::parseConstant(const char* what) {
+    Token literal = currentToken;
+    consume(tok::integer_literal, "Expected an integer.");
+    uint64_t value = 0;
+    for (char digit : literal.lexeme) {
+        if (value > (UINT64_MAX - (digit - '0')) / 10) {
+            std::cerr << "Parse Error on line " << literal.line << ": " << what << " is too large." << std::endl;
+            exit(1);
+        }
+        value = value * 10 + (digit - '0');
+    }
+    if (value == 0) {
+        std::cerr << "Parse Error on line " << literal.line << ": " << what << " must be at least 1." << std::endl;
+        exit(1);
+    }
+    return value;
+}
+
+std::vector<std::unique_ptr<Stmt>> Parser::parseFunctionBody() {
     consume(tok::l_brace, "Expected '{' before function body.");
 
     std::vector<std::unique_ptr<Stmt>> body;
@@ -81,39 +387,282 @@ std::unique_ptr<FunctionDecl> Parser::parseFunctionDefinition() {
     }
 
     consume(tok::r_brace, "Expected '}' after function body.");
+    return body;
+}
 
-    return std::make_unique<FunctionDecl>(name, std::move(body));
+std::unique_ptr<FunctionDecl> Parser::skimFunctionBody(const Token& name, std::vector<Param> params) {
+    Token open = currentToken;
+    consume(tok::l_brace, "Expected '{' before function body.");
+
+    // Match braces without building any AST, noting every identifier that
+    // is directly followed by '(' as a possible callee.
+    std::vector<std::string_view> callees;
+    unsigned depth = 1;
+    while (!isAtEnd()) {
+        if (currentToken.kind == tok::l_brace) {
+            ++depth;
+        } else if (currentToken.kind == tok::r_brace && --depth == 0) {
+            break;
+        } else if (currentToken.kind == tok::l_paren && previousToken.kind == tok::identifier) {
+            callees.push_back(previousToken.lexeme);
+        }
+        advance();
+    }
+
+    Token close = currentToken;
+    consume(tok::r_brace, "Expected '}' after function body.");
+
+    std::string_view text(open.lexeme.data(),
+                          close.lexeme.data() + close.lexeme.size() - open.lexeme.data());
+    auto fn = std::make_unique<FunctionDecl>(name, std::move(params), std::vector<std::unique_ptr<Stmt>>());
+    fn->setSkimmedBody(text, open.line, std::move(callees));
+    return fn;
 }
 
 std::unique_ptr<Stmt> Parser::parseStatement() {
     if (match(tok::kw_let)) {
         return parseVarDeclStatement();
     }
+    if (match(tok::kw_spawn)) {
+        return parseSpawnStatement();
+    }
+    if (match(tok::kw_region)) {
+        return parseRegionStatement();
+    }
+    if (match(tok::kw_join)) {
+        consume(tok::semicolon, "Expected ';' after 'join'.");
+        return std::make_unique<JoinStmt>();
+    }
+    if (match(tok::kw_return)) {
+        std::unique_ptr<Expr> value;
+        if (currentToken.kind != tok::semicolon) {
+            value = parseExpression();
+        }
+        consume(tok::semicolon, "Expected ';' after return value.");
+        return std::make_unique<ReturnStmt>(std::move(value));
+    }
+    if (match(tok::kw_if)) {
+        return parseIfStatement();
+    }
+    if (match(tok::kw_while)) {
+        return parseWhileStatement();
+    }
+    if (match(tok::kw_for)) {
+        return parseForStatement();
+    }
     return parseExprStatement();
 }
 
+std::unique_ptr<Expr> Parser::parseHeaderExpression() {
+    bool outerNoStructLiterals = noStructLiterals;
+    noStructLiterals = true;
+    std::unique_ptr<Expr> expr = parseExpression();
+    noStructLiterals = outerNoStructLiterals;
+    return expr;
+}
+
+std::unique_ptr<WhileStmt> Parser::parseWhileStatement() {
+    std::unique_ptr<Expr> cond = parseHeaderExpression();
+    consume(tok::l_brace, "Expected '{' after 'while' condition.");
+    return std::make_unique<WhileStmt>(std::move(cond), parseBlockStatements());
+}
+
+std::unique_ptr<ForStmt> Parser::parseForStatement() {
+    Token var = currentToken;
+    consume(tok::identifier, "Expected loop variable name after 'for'.");
+    consume(tok::kw_in, "Expected 'in' after the loop variable.");
+    std::unique_ptr<Expr> lo = parseHeaderExpression();
+    consume(tok::dotdot, "Expected '..' in the loop range.");
+    std::unique_ptr<Expr> hi = parseHeaderExpression();
+    consume(tok::l_brace, "Expected '{' after the loop range.");
+    return std::make_unique<ForStmt>(var, std::move(lo), std::move(hi), parseBlockStatements());
+}
+
+std::unique_ptr<IfStmt> Parser::parseIfStatement() {
+    std::unique_ptr<Expr> cond = parseHeaderExpression();
+    consume(tok::l_brace, "Expected '{' after 'if' condition.");
+    auto thenBody = parseBlockStatements();
+
+    std::vector<std::unique_ptr<Stmt>> elseBody;
+    if (match(tok::kw_else)) {
+        if (match(tok::kw_if)) {
+            elseBody.push_back(parseIfStatement());
+        } else {
+            consume(tok::l_brace, "Expected '{' or 'if' after 'else'.");
+            elseBody = parseBlockStatements();
+        }
+    }
+    return std::make_unique<IfStmt>(std::move(cond), std::move(thenBody), std::move(elseBody));
+}
+
+std::vector<std::unique_ptr<Stmt>> Parser::parseBlockStatements() {
+    std::vector<std::unique_ptr<Stmt>> body;
+    while (currentToken.kind != tok::r_brace && !isAtEnd()) {
+        body.push_back(parseStatement());
+    }
+    consume(tok::r_brace, "Expected '}' after block.");
+    return body;
+}
+
 std::unique_ptr<DeclStmt> Parser::parseVarDeclStatement() {
     Token name = currentToken;
     consume(tok::identifier, "Expected variable name.");
-    consume(tok::equal, "Expected '=' after variable name.");
 
-    std::unique_ptr<Expr> initializer = parseExpression();
+    Type declaredType;
+    if (match(tok::colon)) {
+        declaredType = parseType();
+        if (declaredType.isVoid()) {
+            std::cerr << "Parse Error on line " << name.line << ": Variable '"
+                      << name.lexeme << "' cannot have type 'void'." << std::endl;
+            exit(1);
+        }
+    }
+
+    std::unique_ptr<Expr> initializer;
+    if (declaredType.isVoid() || currentToken.kind == tok::equal) {
+        consume(tok::equal, "Expected '=' after variable name.");
+        initializer = parseExpression();
+    }
 
     consume(tok::semicolon, "Expected ';' after variable declaration.");
 
-    auto varDecl = std::make_unique<VarDecl>(name, std::move(initializer));
+    auto varDecl = std::make_unique<VarDecl>(name, std::move(initializer), std::move(declaredType));
     return std::make_unique<DeclStmt>(std::move(varDecl));
 }
 
-std::unique_ptr<ExprStmt> Parser::parseExprStatement() {
+// Whether 'expr' names a place a value can be stored in: a variable, or a
+// field or element of one.
+static bool isAssignable(Expr* expr) {
+    if (auto* field = dynamic_cast<FieldExpr*>(expr)) {
+        return isAssignable(field->getBase());
+    }
+    if (auto* index = dynamic_cast<IndexExpr*>(expr)) {
+        return isAssignable(index->getBase());
+    }
+    return dynamic_cast<VariableExpr*>(expr) != nullptr;
+}
+
+std::unique_ptr<Stmt> Parser::parseExprStatement() {
     std::unique_ptr<Expr> expr = parseExpression();
+    if (match(tok::equal)) {
+        unsigned line = previousToken.line;
+        if (!isAssignable(expr.get())) {
+            std::cerr << "Parse Error on line " << line << ": Only a variable, or a field or"
+                      << " element of one, can be assigned to." << std::endl;
+            exit(1);
+        }
+        std::unique_ptr<Expr> value = parseExpression();
+        consume(tok::semicolon, "Expected ';' after assignment.");
+        return std::make_unique<AssignStmt>(std::move(expr), std::move(value));
+    }
     consume(tok::semicolon, "Expected ';' after expression.");
     return std::make_unique<ExprStmt>(std::move(expr));
 }
 
+std::unique_ptr<SpawnStmt> Parser::parseSpawnStatement() {
+    unsigned line = previousToken.line;
+    std::unique_ptr<Expr> expr = parseExpression();
+    consume(tok::semicolon, "Expected ';' after spawned call.");
+
+    auto* call = dynamic_cast<CallExpr*>(expr.get());
+    if (!call) {
+        std::cerr << "Parse Error on line " << line << ": 'spawn' must be followed by a function call." << std::endl;
+        exit(1);
+    }
+    expr.release();
+    return std::make_unique<SpawnStmt>(std::unique_ptr<CallExpr>(call));
+}
+
+std::unique_ptr<RegionStmt> Parser::parseRegionStatement() {
+    consume(tok::l_brace, "Expected '{' after 'region'.");
+
+    std::vector<std::unique_ptr<Stmt>> body;
+    while (currentToken.kind != tok::r_brace && !isAtEnd()) {
+        body.push_back(parseStatement());
+    }
+
+    consume(tok::r_brace, "Expected '}' after region body.");
+    return std::make_unique<RegionStmt>(std::move(body));
+}
+
 std::unique_ptr<Expr> Parser::parseExpression() {
-    // For now, our only expressions are primary expressions (literals, identifiers, calls)
-    return parsePrimaryExpression();
+    return parseComparison();
+}
+
+// Comparisons bind the loosest, then '+' and '-', then '*', '/' and '%'.
+// All binary operators are left-associative.
+std::unique_ptr<Expr> Parser::parseComparison() {
+    std::unique_ptr<Expr> expr = parseAdditive();
+    while (match(tok::less) || match(tok::less_equal) || match(tok::greater) ||
+           match(tok::greater_equal) || match(tok::equal_equal) || match(tok::bang_equal)) {
+        Token op = previousToken;
+        expr = std::make_unique<BinaryExpr>(op, std::move(expr), parseAdditive());
+    }
+    return expr;
+}
+
+std::unique_ptr<Expr> Parser::parseAdditive() {
+    std::unique_ptr<Expr> expr = parseMultiplicative();
+    while (match(tok::plus) || match(tok::minus)) {
+        Token op = previousToken;
+        expr = std::make_unique<BinaryExpr>(op, std::move(expr), parseMultiplicative());
+    }
+    return expr;
+}
+
+std::unique_ptr<Expr> Parser::parseMultiplicative() {
+    std::unique_ptr<Expr> expr = parsePostfixExpression();
+    while (match(tok::star) || match(tok::slash) || match(tok::percent)) {
+        Token op = previousToken;
+        expr = std::make_unique<BinaryExpr>(op, std::move(expr), parsePostfixExpression());
+    }
+    return expr;
+}
+
+std::unique_ptr<Expr> Parser::parsePostfixExpression() {
+    std::unique_ptr<Expr> expr = parsePrimaryExpression();
+    while (true) {
+        if (match(tok::dot)) {
+            Token name = currentToken;
+            consume(tok::identifier, "Expected field name after '.'.");
+            expr = std::make_unique<FieldExpr>(std::move(expr), name);
+        } else if (match(tok::l_square)) {
+            std::unique_ptr<Expr> index = parseNestedExpression();
+            if (match(tok::dotdot)) {
+                std::unique_ptr<Expr> hi = parseNestedExpression();
+                consume(tok::r_square, "Expected ']' after slice range.");
+                expr = std::make_unique<SliceExpr>(std::move(expr), std::move(index), std::move(hi));
+                continue;
+            }
+            consume(tok::r_square, "Expected ']' after index.");
+            expr = std::make_unique<IndexExpr>(std::move(expr), std::move(index));
+        } else {
+            return expr;
+        }
+    }
+}
+
+std::unique_ptr<Expr> Parser::parseNestedExpression() {
+    bool outerNoStructLiterals = noStructLiterals;
+    noStructLiterals = false;
+    std::unique_ptr<Expr> expr = parseExpression();
+    noStructLiterals = outerNoStructLiterals;
+    return expr;
+}
+
+std::unique_ptr<StructLiteralExpr> Parser::parseStructLiteral(const Token& name) {
+    std::vector<std::pair<Token, std::unique_ptr<Expr>>> fields;
+    while (currentToken.kind != tok::r_brace && !isAtEnd()) {
+        Token fieldName = currentToken;
+        consume(tok::identifier, "Expected field name.");
+        consume(tok::colon, "Expected ':' after field name.");
+        fields.emplace_back(fieldName, parseNestedExpression());
+        if (!match(tok::comma)) {
+            break;
+        }
+    }
+    consume(tok::r_brace, "Expected '}' after struct fields.");
+    return std::make_unique<StructLiteralExpr>(name, std::move(fields));
 }
 
 std::unique_ptr<Expr> Parser::parsePrimaryExpression() {
@@ -121,24 +670,53 @@ std::unique_ptr<Expr> Parser::parsePrimaryExpression() {
         return std::make_unique<StringLiteralExpr>(previousToken);
     }
 
+    if (match(tok::integer_literal)) {
+        return std::make_unique<IntegerLiteralExpr>(previousToken);
+    }
+
+    if (match(tok::kw_true) || match(tok::kw_false)) {
+        return std::make_unique<BoolLiteralExpr>(previousToken);
+    }
+
+    if (match(tok::l_paren)) {
+        std::unique_ptr<Expr> expr = parseNestedExpression();
+        consume(tok::r_paren, "Expected ')' after expression.");
+        return expr;
+    }
+
+    if (match(tok::kw_await)) {
+        unsigned line = previousToken.line;
+        std::unique_ptr<Expr> expr = parsePrimaryExpression();
+        auto* call = dynamic_cast<CallExpr*>(expr.get());
+        if (!call) {
+            std::cerr << "Parse Error on line " << line << ": 'await' must be followed by a function call." << std::endl;
+            exit(1);
+        }
+        expr.release();
+        return std::make_unique<AwaitExpr>(std::unique_ptr<CallExpr>(call));
+    }
+
     if (match(tok::identifier)) {
         Token callee = previousToken;
         if (match(tok::l_paren)) {
             // It's a function call
             std::vector<std::unique_ptr<Expr>> args;
             if (currentToken.kind != tok::r_paren) {
-                // Parse arguments (just one for now for hello.sa)
-                args.push_back(parseExpression());
+                do {
+                    args.push_back(parseNestedExpression());
+                } while (match(tok::comma));
             }
             consume(tok::r_paren, "Expected ')' after arguments.");
             return std::make_unique<CallExpr>(callee, std::move(args));
+        } else if (!noStructLiterals && match(tok::l_brace)) {
+            return parseStructLiteral(callee);
         } else {
             // It's a variable usage
             return std::make_unique<VariableExpr>(callee);
         }
     }
 
-    std::cerr << "Parse Error: Expected an expression." << std::endl;
+    std::cerr << "Parse Error on line " << currentToken.line << ": Expected an expression." << std::endl;
     exit(1);
 }
 
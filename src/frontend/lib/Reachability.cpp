@@ -0,0 +1,59 @@
+//===--- Reachability.cpp - Reachability-driven Body Parsing ----*- C++ -*-===//
+//
+// This file implements parseReachableBodies.
+//
+//===----------------------------------------------------------------------===//
+
+#include "frontend/include/Reachability.h"
+#include "frontend/include/Lexer.h"
+#include "frontend/include/Parser.h"
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+
+namespace sa {
+
+void parseReachableBodies(std::vector<std::unique_ptr<Decl>>& ast) {
+    std::unordered_map<std::string_view, FunctionDecl*> functions;
+    std::vector<FunctionDecl*> worklist;
+    std::set<FunctionDecl*> reached;
+
+    for (const auto& decl : ast) {
+        if (auto* fn = dynamic_cast<FunctionDecl*>(decl.get())) {
+            functions.emplace(fn->getName(), fn);
+            if (fn->getName() == "main" || fn->isExported()) {
+                if (reached.insert(fn).second) {
+                    worklist.push_back(fn);
+                }
+            }
+        }
+    }
+
+    while (!worklist.empty()) {
+        FunctionDecl* fn = worklist.back();
+        worklist.pop_back();
+
+        for (std::string_view callee : fn->getSkimmedCallees()) {
+            auto it = functions.find(callee);
+            if (it != functions.end() && reached.insert(it->second).second) {
+                worklist.push_back(it->second);
+            }
+        }
+
+        if (fn->isSkimmed()) {
+            Lexer lexer(fn->getSkimmedBody(), fn->getSkimmedBodyLine());
+            Parser parser(lexer);
+            parser.setTypeParams(fn->getTypeParams());
+            fn->setBody(parser.parseFunctionBody());
+        }
+    }
+
+    ast.erase(std::remove_if(ast.begin(), ast.end(),
+                             [&](const std::unique_ptr<Decl>& decl) {
+                                 auto* fn = dynamic_cast<FunctionDecl*>(decl.get());
+                                 return fn && !reached.count(fn);
+                             }),
+              ast.end());
+}
+
+} // namespace sa
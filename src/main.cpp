@@ -31,26 +31,154 @@
 // ============================================================================
 
 #include "core/include/Token.h"
+#include "frontend/include/BoundsCheck.h"
 #include "frontend/include/Lexer.h"
+#include "frontend/include/ParallelLexer.h"
 #include "frontend/include/Parser.h"
+#include "frontend/include/Reachability.h"
 #include "backend/include/CodeGen.h"
+#include "backend/include/Linker.h"
+#include "serialization/include/ModuleReader.h"
+#include "serialization/include/ModuleWriter.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/TargetParser/Host.h"
 #include <iostream>
 #include <fstream>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
 
 // We will write a simple AST printer later to test this properly.
 // For now, we just want it to compile and run without crashing.
 
+// The --emit= kinds and the extension of the file each is written to.
+struct EmitKind {
+    std::string_view Name;
+    sa::OutputKind Kind;
+    const char* Extension;
+};
+static const EmitKind EmitKinds[] = {
+    {"llvm-ir", sa::OutputKind::LLVMIR, ".ll"},
+    {"llvm-bc", sa::OutputKind::LLVMBitcode, ".bc"},
+    {"asm", sa::OutputKind::Assembly, ".s"},
+    {"obj", sa::OutputKind::Object, ".o"},
+};
+
+static void printUsage() {
+    std::cerr << "Usage: sac [options] <filename.sa>\n"
+              << "Options:\n"
+              << "  -o <file>                 Compile and link an executable (default: print LLVM IR),\n"
+              << "                            or write the --emit output to <file> ('-' for stdout)\n"
+              << "  --emit=<kind>             Write llvm-ir, llvm-bc, asm or obj instead of linking\n"
+              << "                            (default file: <input>.ll/.bc/.s/.o; llvm-ir to stdout)\n"
+              << "  --stream-output           Flush llvm-bc to the file while writing it, for huge modules\n"
+              << "  -I <dir>                  Add a directory to search for imported modules\n"
+              << "  --emit-interface=<file>   Also write the module interface (.sai) to <file>\n"
+              << "  --lex-threads=<n>         Lex with <n> threads (default: all cores for large files)\n"
+              << "  --lazy-bodies             Only parse and compile functions reachable from 'main'\n"
+              << "                            or an exported function\n"
+              << "  --stream                  Parse, compile and free one function body at a time, so\n"
+              << "                            memory grows with the largest function, not the file\n"
+              << "  --target=<triple>         Compile for <triple> (default: arm64-apple-macos, or the\n"
+              << "                            host with --march)\n"
+              << "  --march=<cpu>             Use the instructions of <cpu>; 'native' for this machine\n"
+              << "  --runtime=<kind>          Link with the 'full' runtime (default) or the 'minimal'\n"
+              << "                            one: static, no libc, no threads; Linux only\n"
+              << "  -O<n>                     Optimize at level 0 (default), 1, 2 or 3\n"
+              << "  --bounds-checks=<mode>    'on' (default), 'off', or 'stats' to also print how many\n"
+              << "                            checks each function kept, hoisted and removed\n";
+}
+
 int main(int argc, char** argv) {
-    if (argc != 2) {
-        std::cerr << "Usage: sac <filename.sa>" << std::endl;
+    const char* inputPath = nullptr;
+    std::string interfacePath;
+    std::string outputPath;
+    std::vector<std::string> importPaths;
+    unsigned lexThreads = 0; // 0: decide based on the file size.
+    bool lazyBodies = false;
+    bool streaming = false;
+    const EmitKind* emit = nullptr; // Null: print IR, or link with -o.
+    bool streamOutput = false;
+    sa::CodeGenOptions codeGenOptions;
+    sa::RuntimeKind runtime = sa::RuntimeKind::Full;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "-o" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "-I" && i + 1 < argc) {
+            importPaths.push_back(argv[++i]);
+        } else if (arg.size() > 2 && arg.substr(0, 2) == "-I") {
+            importPaths.push_back(std::string(arg.substr(2)));
+        } else if (arg.substr(0, 17) == "--emit-interface=") {
+            interfacePath = std::string(arg.substr(17));
+        } else if (arg.substr(0, 14) == "--lex-threads=") {
+            if (llvm::StringRef(arg.substr(14)).getAsInteger(10, lexThreads)) {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--lazy-bodies") {
+            lazyBodies = true;
+        } else if (arg == "--stream") {
+            streaming = true;
+        } else if (arg.substr(0, 7) == "--emit=") {
+            for (const EmitKind& kind : EmitKinds) {
+                if (arg.substr(7) == kind.Name) {
+                    emit = &kind;
+                }
+            }
+            if (!emit) {
+                printUsage();
+                return 1;
+            }
+        } else if (arg == "--stream-output") {
+            streamOutput = true;
+        } else if (arg.substr(0, 9) == "--target=") {
+            codeGenOptions.TargetTriple = std::string(arg.substr(9));
+        } else if (arg.substr(0, 8) == "--march=") {
+            codeGenOptions.CPU = std::string(arg.substr(8));
+        } else if (arg == "--runtime=full") {
+            runtime = sa::RuntimeKind::Full;
+        } else if (arg == "--runtime=minimal") {
+            runtime = sa::RuntimeKind::Minimal;
+        } else if (arg.size() == 3 && arg.substr(0, 2) == "-O" && arg[2] >= '0' && arg[2] <= '3') {
+            codeGenOptions.OptLevel = arg[2] - '0';
+        } else if (arg.substr(0, 16) == "--bounds-checks=") {
+            std::string_view mode = arg.substr(16);
+            if (mode == "on") {
+                codeGenOptions.BoundsChecks = sa::BoundsCheckMode::On;
+            } else if (mode == "off") {
+                codeGenOptions.BoundsChecks = sa::BoundsCheckMode::Off;
+            } else if (mode == "stats") {
+                codeGenOptions.BoundsChecks = sa::BoundsCheckMode::Stats;
+            } else {
+                printUsage();
+                return 1;
+            }
+        } else if (arg.empty() || arg[0] == '-' || inputPath) {
+            printUsage();
+            return 1;
+        } else {
+            inputPath = argv[i];
+        }
+    }
+    if (!inputPath) {
+        printUsage();
+        return 1;
+    }
+    // Both need every body at once.
+    if (streaming && (lazyBodies || !interfacePath.empty())) {
+        std::cerr << "Error: --stream cannot be combined with --lazy-bodies or --emit-interface." << std::endl;
         return 1;
     }
 
-    std::ifstream file(argv[1]);
+    std::ifstream file(inputPath);
     if (!file.is_open()) {
-        std::cerr << "Error: Could not open file '" << argv[1] << "'" << std::endl;
+        std::cerr << "Error: Could not open file '" << inputPath << "'" << std::endl;
         return 1;
     }
 
@@ -59,13 +187,115 @@ int main(int argc, char** argv) {
     std::string sourceCode = buffer.str();
 
     // -- Frontend --
-    sa::Lexer lexer(sourceCode);
-    sa::Parser parser(lexer);
+    // Huge files are lexed in parallel chunks up front; the parser sees the
+    // same tokens either way.
+    if (lexThreads == 0) {
+        lexThreads = sourceCode.size() >= sa::ParallelLexThreshold ? std::thread::hardware_concurrency() : 1;
+    }
+    std::unique_ptr<sa::TokenSource> tokens;
+    if (lexThreads > 1 && !streaming) {
+        tokens = std::make_unique<sa::TokenBuffer>(sa::lexInParallel(sourceCode, lexThreads));
+    } else {
+        tokens = std::make_unique<sa::Lexer>(sourceCode);
+    }
+    // Streaming starts out like --lazy-bodies: skimming the file yields the
+    // signature of every function, but none of the bodies yet.
+    sa::Parser parser(*tokens);
+    parser.setSkimFunctionBodies(lazyBodies || streaming);
     auto ast = parser.parse();
+    if (lazyBodies) {
+        sa::parseReachableBodies(ast);
+    }
+    if (!streaming) {
+        sa::eliminateBoundsChecks(ast);
+    }
+
+    // The minimal runtime has no event loop for async functions to run on.
+    if (runtime == sa::RuntimeKind::Minimal) {
+        for (const auto& decl : ast) {
+            auto* fn = dynamic_cast<sa::FunctionDecl*>(decl.get());
+            if (fn && fn->isAsync()) {
+                std::cerr << "Error: Async function '" << fn->getName()
+                          << "' needs the event loop of the full runtime; it cannot be compiled "
+                             "with --runtime=minimal." << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    // -- Modules --
+    // Imports are resolved against precompiled interfaces, never against the
+    // dependency's source: the directory of the input file is searched first.
+    sa::ModuleLoader loader;
+    llvm::StringRef inputDir = llvm::sys::path::parent_path(inputPath);
+    loader.addSearchPath(inputDir.empty() ? "." : inputDir.str());
+    for (auto& dir : importPaths) {
+        loader.addSearchPath(std::move(dir));
+    }
+    if (!loader.resolveImports(ast)) {
+        return 1;
+    }
+
+    if (!interfacePath.empty()) {
+        std::string moduleName = llvm::sys::path::stem(inputPath).str();
+        if (!sa::writeModuleInterface(ast, moduleName, interfacePath)) {
+            return 1;
+        }
+    }
 
     // Backend
-    sa::CodeGen generator;
-    generator.run(ast);
+    // An executable is built to run here, so it targets the host by default.
+    bool linking = !outputPath.empty() && !emit;
+    if (linking && codeGenOptions.TargetTriple.empty()) {
+        codeGenOptions.TargetTriple = llvm::sys::getProcessTriple();
+    }
+    sa::CodeGen generator(codeGenOptions);
+    if (!streaming) {
+        generator.run(ast);
+    } else {
+        generator.begin();
+        for (const auto& decl : ast) {
+            generator.declare(*decl);
+        }
+        for (const auto& decl : ast) {
+            auto* fn = dynamic_cast<sa::FunctionDecl*>(decl.get());
+            if (!fn) {
+                continue;
+            }
+            sa::Lexer bodyLexer(fn->getSkimmedBody(), fn->getSkimmedBodyLine());
+            sa::Parser bodyParser(bodyLexer);
+            bodyParser.setTypeParams(fn->getTypeParams());
+            fn->setBody(bodyParser.parseFunctionBody());
+            sa::eliminateBoundsChecks(*fn);
+            generator.emit(*fn);
+            if (!fn->isGeneric()) {
+                fn->releaseBody();
+            }
+        }
+        generator.finish();
+    }
+    if (!linking) {
+        if (!emit) {
+            return generator.emitOutput("-", sa::OutputKind::LLVMIR) ? 0 : 1;
+        }
+        if (outputPath.empty()) {
+            outputPath = emit->Kind == sa::OutputKind::LLVMIR
+                ? "-"
+                : llvm::sys::path::stem(inputPath).str() + emit->Extension;
+        }
+        return generator.emitOutput(outputPath, emit->Kind, streamOutput) ? 0 : 1;
+    }
 
-    return 0;
+    // -- Linking --
+    // The object only lives until lld has read it.
+    llvm::SmallString<128> objectPath;
+    if (llvm::sys::fs::createTemporaryFile("sa", "o", objectPath)) {
+        std::cerr << "Error: Could not create a temporary object file." << std::endl;
+        return 1;
+    }
+    bool linked = generator.emitOutput(std::string(objectPath), sa::OutputKind::Object) &&
+                  sa::linkExecutable({std::string(objectPath)}, outputPath,
+                                     generator.getTargetTriple(), argv[0], runtime);
+    llvm::sys::fs::remove(objectPath);
+    return linked ? 0 : 1;
 }
\ No newline at end of file
@@ -0,0 +1,79 @@
+//===--- ModuleFormat.h - The 'sa' Module Interface Format ------*- C++ -*-===//
+//
+// This file defines the on-disk layout of precompiled module interface files
+// (.sai). An interface holds everything a dependent compile needs from a
+// module: its exported function signatures and, for small functions, their
+// bodies so they can still be inlined across module boundaries.
+//
+// All integers are little-endian. A string is a u32 length followed by its
+// bytes (no terminator), so a reader can hand out views straight into the
+// mapped file instead of copying.
+//
+//   magic[4] "SAMI"   version:u32   name:str
+//   numImports:u32    { module:str }*
+//   numFunctions:u32  { name:str returnType:u8 numParams:u32
+//                       { name:str type:u8 }* attrs:u32
+//                       flags:u8 [ numStmts:u32 stmt* ] }*
+//
+// 'attrs' is the FunctionAttr bit set of the declaration. Generic functions
+// and functions taking or returning structs, arrays or slices cannot be exported,
+// so a type is always one of the built-in TypeCodes.
+//
+//   stmt := Let name:str expr | Expr expr | Return hasValue:u8 [expr]
+//         | If expr numThen:u32 stmt* numElse:u32 stmt*
+//   expr := StringLiteral lexeme:str | Variable name:str
+//         | Call callee:str numArgs:u32 expr*
+//         | IntegerLiteral digits:str | BoolLiteral value:u8
+//         | Binary op:str expr expr
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+namespace sa {
+namespace serialization {
+
+    constexpr char ModuleMagic[4] = {'S', 'A', 'M', 'I'};
+
+    // Bumped whenever the layout above changes. Readers reject other versions.
+    constexpr uint32_t ModuleVersion = 4;
+
+    // The file extension of module interfaces, looked up by 'import name;'.
+    constexpr const char* ModuleFileExtension = ".sai";
+
+    // Exported functions with at most this many statements, or marked
+    // '@inline', keep their body in the interface so that importers can
+    // inline them. '@noinline' functions never do.
+    constexpr unsigned MaxInlineableStmts = 16;
+
+    enum class TypeCode : uint8_t {
+        Void = 0,
+        Str = 1,
+        I64 = 2,
+        Bool = 3,
+    };
+
+    enum FunctionFlags : uint8_t {
+        FF_HasBody = 1 << 0,
+    };
+
+    enum class StmtCode : uint8_t {
+        Let = 1,
+        Expr = 2,
+        Return = 3,
+        If = 4,
+    };
+
+    enum class ExprCode : uint8_t {
+        StringLiteral = 1,
+        Variable = 2,
+        Call = 3,
+        IntegerLiteral = 4,
+        BoolLiteral = 5,
+        Binary = 6,
+    };
+
+} // namespace serialization
+} // namespace sa
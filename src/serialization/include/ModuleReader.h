@@ -0,0 +1,65 @@
+//===--- ModuleReader.h - The 'sa' Module Interface Reader ------*- C++ -*-===//
+//
+// This file defines ModuleFile, an in-memory view of a precompiled module
+// interface, and ModuleLoader, which resolves 'import' declarations to them.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "ast/include/Decl.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sa {
+
+// A loaded module interface. The file is memory-mapped and never copied:
+// the names and literals of the materialized declarations point straight
+// into the mapping, so a ModuleFile must outlive every AST that uses it.
+class ModuleFile {
+public:
+    // Maps and decodes the interface at 'path'. Returns nullptr (after
+    // printing a diagnostic) if the file is missing or malformed.
+    static std::shared_ptr<ModuleFile> load(const std::string& path);
+
+    std::string_view getName() const { return Name; }
+
+    // The modules this interface was compiled against.
+    const std::vector<std::string_view>& getImports() const { return Imports; }
+    const std::vector<std::shared_ptr<ModuleFile>>& getDependencies() const { return Dependencies; }
+    void addDependency(std::shared_ptr<ModuleFile> dep) { Dependencies.push_back(std::move(dep)); }
+
+    // The exported functions, already marked as imported.
+    const std::vector<std::unique_ptr<FunctionDecl>>& getFunctions() const { return Functions; }
+
+private:
+    std::unique_ptr<llvm::MemoryBuffer> Buffer;
+    std::string_view Name;
+    std::vector<std::string_view> Imports;
+    std::vector<std::shared_ptr<ModuleFile>> Dependencies;
+    std::vector<std::unique_ptr<FunctionDecl>> Functions;
+};
+
+// Finds and loads the interfaces named by 'import' declarations. Each module
+// is loaded at most once, however many times it is imported.
+class ModuleLoader {
+public:
+    // Adds a directory to search for '<name>.sai' files, in order.
+    void addSearchPath(std::string dir) { SearchPaths.push_back(std::move(dir)); }
+
+    // Attaches a loaded module to every ImportDecl in 'ast'. Returns false
+    // if any import could not be resolved.
+    bool resolveImports(const std::vector<std::unique_ptr<Decl>>& ast);
+
+private:
+    std::shared_ptr<ModuleFile> loadModule(std::string_view name);
+
+    std::vector<std::string> SearchPaths;
+    std::map<std::string, std::shared_ptr<ModuleFile>, std::less<>> Loaded;
+};
+
+} // namespace sa
@@ -0,0 +1,25 @@
+//===--- ModuleWriter.h - The 'sa' Module Interface Writer ------*- C++ -*-===//
+//
+// This file declares the entry point for writing a module interface file
+// from a parsed 'sa' AST.
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "ast/include/Decl.h"
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace sa {
+
+// Serializes the exported declarations of 'ast' into a module interface
+// named 'moduleName' and writes it to 'path'. Returns false (after printing
+// a diagnostic) if the file could not be written.
+bool writeModuleInterface(const std::vector<std::unique_ptr<Decl>>& ast,
+                          std::string_view moduleName,
+                          const std::string& path);
+
+} // namespace sa
@@ -0,0 +1,298 @@
+//===--- ModuleReader.cpp - The 'sa' Module Interface Reader ----*- C++ -*-===//
+//
+// This file implements loading module interface files.
+//
+//===----------------------------------------------------------------------===//
+
+#include "serialization/include/ModuleReader.h"
+#include "serialization/include/ModuleFormat.h"
+#include "ast/include/Stmt.h"
+#include "ast/include/Expr.h"
+
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace sa {
+
+using namespace serialization;
+
+namespace {
+
+// A bounds-checked cursor over the mapped file. Any read past the end puts
+// the cursor into a failed state; callers check ok() once per record.
+class Cursor {
+    const char* Ptr;
+    const char* End;
+    bool Failed = false;
+
+public:
+    Cursor(llvm::StringRef data) : Ptr(data.begin()), End(data.end()) {}
+
+    bool ok() const { return !Failed; }
+    void fail() { Failed = true; }
+
+    bool has(size_t size) {
+        if (Failed || static_cast<size_t>(End - Ptr) < size) {
+            Failed = true;
+            return false;
+        }
+        return true;
+    }
+
+    uint8_t readU8() {
+        if (!has(1)) return 0;
+        return static_cast<uint8_t>(*Ptr++);
+    }
+
+    uint32_t readU32() {
+        if (!has(4)) return 0;
+        uint32_t value = llvm::support::endian::read32le(Ptr);
+        Ptr += 4;
+        return value;
+    }
+
+    std::string_view readBytes(size_t size) {
+        if (!has(size)) return {};
+        std::string_view bytes(Ptr, size);
+        Ptr += size;
+        return bytes;
+    }
+
+    std::string_view readString() { return readBytes(readU32()); }
+};
+
+// Builds a token whose lexeme points into the mapped file.
+Token makeToken(tok::TokenKind kind, std::string_view lexeme) {
+    return Token{kind, lexeme, 0};
+}
+
+// Decodes a type. Returns false for anything that is not a TypeCode.
+bool readType(Cursor& in, Type& type) {
+    switch (static_cast<TypeCode>(in.readU8())) {
+        case TypeCode::Void: type = TypeKind::Void; return true;
+        case TypeCode::Str:  type = TypeKind::Str;  return true;
+        case TypeCode::I64:  type = TypeKind::I64;  return true;
+        case TypeCode::Bool: type = TypeKind::Bool; return true;
+    }
+    return false;
+}
+
+// The operator token kind with the given spelling, or tok::unknown.
+tok::TokenKind getOperatorKind(std::string_view spelling) {
+#define PUNCTUATOR(X, Y) if (spelling == Y) return tok::X;
+#include "core/include/TokenKind.def"
+    return tok::unknown;
+}
+
+std::unique_ptr<Stmt> readStmt(Cursor& in);
+
+bool readStmts(Cursor& in, std::vector<std::unique_ptr<Stmt>>& stmts) {
+    uint32_t numStmts = in.readU32();
+    for (uint32_t i = 0; i < numStmts && in.ok(); ++i) {
+        auto stmt = readStmt(in);
+        if (!stmt) return false;
+        stmts.push_back(std::move(stmt));
+    }
+    return in.ok();
+}
+
+std::unique_ptr<Expr> readExpr(Cursor& in) {
+    switch (static_cast<ExprCode>(in.readU8())) {
+        case ExprCode::StringLiteral:
+            return std::make_unique<StringLiteralExpr>(makeToken(tok::string_literal, in.readString()));
+        case ExprCode::Variable:
+            return std::make_unique<VariableExpr>(makeToken(tok::identifier, in.readString()));
+        case ExprCode::Call: {
+            Token callee = makeToken(tok::identifier, in.readString());
+            uint32_t numArgs = in.readU32();
+            std::vector<std::unique_ptr<Expr>> args;
+            for (uint32_t i = 0; i < numArgs && in.ok(); ++i) {
+                auto arg = readExpr(in);
+                if (!arg) return nullptr;
+                args.push_back(std::move(arg));
+            }
+            return std::make_unique<CallExpr>(callee, std::move(args));
+        }
+        case ExprCode::IntegerLiteral:
+            return std::make_unique<IntegerLiteralExpr>(makeToken(tok::integer_literal, in.readString()));
+        case ExprCode::BoolLiteral:
+            return std::make_unique<BoolLiteralExpr>(
+                in.readU8() ? makeToken(tok::kw_true, "true") : makeToken(tok::kw_false, "false"));
+        case ExprCode::Binary: {
+            std::string_view spelling = in.readString();
+            Token op = makeToken(getOperatorKind(spelling), spelling);
+            if (op.kind == tok::unknown) return nullptr;
+            auto lhs = readExpr(in);
+            if (!lhs) return nullptr;
+            auto rhs = readExpr(in);
+            if (!rhs) return nullptr;
+            return std::make_unique<BinaryExpr>(op, std::move(lhs), std::move(rhs));
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<Stmt> readStmt(Cursor& in) {
+    switch (static_cast<StmtCode>(in.readU8())) {
+        case StmtCode::Let: {
+            Token name = makeToken(tok::identifier, in.readString());
+            auto init = readExpr(in);
+            if (!init) return nullptr;
+            return std::make_unique<DeclStmt>(std::make_unique<VarDecl>(name, std::move(init)));
+        }
+        case StmtCode::Expr: {
+            auto expr = readExpr(in);
+            if (!expr) return nullptr;
+            return std::make_unique<ExprStmt>(std::move(expr));
+        }
+        case StmtCode::Return: {
+            std::unique_ptr<Expr> value;
+            if (in.readU8()) {
+                value = readExpr(in);
+                if (!value) return nullptr;
+            }
+            return std::make_unique<ReturnStmt>(std::move(value));
+        }
+        case StmtCode::If: {
+            auto cond = readExpr(in);
+            if (!cond) return nullptr;
+            std::vector<std::unique_ptr<Stmt>> thenBody, elseBody;
+            if (!readStmts(in, thenBody) || !readStmts(in, elseBody)) return nullptr;
+            return std::make_unique<IfStmt>(std::move(cond), std::move(thenBody), std::move(elseBody));
+        }
+    }
+    return nullptr;
+}
+
+std::unique_ptr<FunctionDecl> readFunction(Cursor& in) {
+    Token name = makeToken(tok::identifier, in.readString());
+    Type returnType;
+    if (!readType(in, returnType)) return nullptr;
+    uint32_t numParams = in.readU32();
+    std::vector<Param> params;
+    for (uint32_t i = 0; i < numParams && in.ok(); ++i) {
+        Token paramName = makeToken(tok::identifier, in.readString());
+        Type paramType;
+        if (!readType(in, paramType) || paramType.isVoid()) return nullptr;
+        params.push_back({paramName, paramType});
+    }
+    uint32_t attrs = in.readU32();
+    uint8_t flags = in.readU8();
+
+    std::vector<std::unique_ptr<Stmt>> body;
+    if ((flags & FF_HasBody) && !readStmts(in, body)) return nullptr;
+    if (!in.ok()) return nullptr;
+
+    auto fn = std::make_unique<FunctionDecl>(name, std::move(params), std::move(body));
+    fn->setReturnType(returnType);
+    fn->setExported(true);
+    fn->setAttrs(attrs);
+    fn->markImported(flags & FF_HasBody);
+    return fn;
+}
+
+} // namespace
+
+std::shared_ptr<ModuleFile> ModuleFile::load(const std::string& path) {
+    // No null terminator is needed, which lets MemoryBuffer mmap the file
+    // rather than read it.
+    auto bufferOrErr = llvm::MemoryBuffer::getFile(path, /*IsText=*/false,
+                                                   /*RequiresNullTerminator=*/false);
+    if (!bufferOrErr) {
+        std::cerr << "Error: Could not open module interface '" << path
+                  << "': " << bufferOrErr.getError().message() << std::endl;
+        return nullptr;
+    }
+
+    auto module = std::make_shared<ModuleFile>();
+    module->Buffer = std::move(*bufferOrErr);
+
+    Cursor in(module->Buffer->getBuffer());
+    std::string_view magic = in.readBytes(sizeof(ModuleMagic));
+    bool valid = in.ok() && std::memcmp(magic.data(), ModuleMagic, sizeof(ModuleMagic)) == 0 &&
+                 in.readU32() == ModuleVersion;
+    if (!valid) {
+        std::cerr << "Error: '" << path << "' is not a module interface for this compiler version." << std::endl;
+        return nullptr;
+    }
+
+    module->Name = in.readString();
+
+    uint32_t numImports = in.readU32();
+    for (uint32_t i = 0; i < numImports && in.ok(); ++i) {
+        module->Imports.push_back(in.readString());
+    }
+
+    uint32_t numFunctions = in.readU32();
+    for (uint32_t i = 0; i < numFunctions && in.ok(); ++i) {
+        auto fn = readFunction(in);
+        if (!fn) {
+            in.fail();
+            break;
+        }
+        module->Functions.push_back(std::move(fn));
+    }
+
+    if (!in.ok()) {
+        std::cerr << "Error: Module interface '" << path << "' is corrupt." << std::endl;
+        return nullptr;
+    }
+    return module;
+}
+
+bool ModuleLoader::resolveImports(const std::vector<std::unique_ptr<Decl>>& ast) {
+    bool success = true;
+    for (const auto& decl : ast) {
+        auto* import = dynamic_cast<ImportDecl*>(decl.get());
+        if (!import) continue;
+
+        auto module = loadModule(import->getName());
+        if (!module) {
+            success = false;
+            continue;
+        }
+        import->setModule(std::move(module));
+    }
+    return success;
+}
+
+std::shared_ptr<ModuleFile> ModuleLoader::loadModule(std::string_view name) {
+    auto it = Loaded.find(name);
+    if (it != Loaded.end()) {
+        return it->second;
+    }
+
+    std::string fileName = std::string(name) + ModuleFileExtension;
+    for (const std::string& dir : SearchPaths) {
+        llvm::SmallString<256> path(dir);
+        llvm::sys::path::append(path, fileName);
+        if (!llvm::sys::fs::exists(path)) continue;
+
+        auto module = ModuleFile::load(std::string(path));
+        if (!module) return nullptr;
+        if (module->getName() != name) {
+            std::cerr << "Error: '" << path.c_str() << "' contains module '" << module->getName()
+                      << "', expected '" << name << "'." << std::endl;
+            return nullptr;
+        }
+
+        // Register before loading dependencies so that a stale interface
+        // that (indirectly) imports itself cannot recurse forever.
+        Loaded.emplace(std::string(name), module);
+        for (std::string_view dep : module->getImports()) {
+            auto depModule = loadModule(dep);
+            if (!depModule) return nullptr;
+            if (depModule != module) module->addDependency(std::move(depModule));
+        }
+        return module;
+    }
+
+    std::cerr << "Error: Could not find module '" << name << "' (looked for '" << fileName << "')." << std::endl;
+    return nullptr;
+}
+
+} // namespace sa
@@ -0,0 +1,259 @@
+//===--- ModuleWriter.cpp - The 'sa' Module Interface Writer ----*- C++ -*-===//
+//
+// This file implements writing module interface files.
+//
+//===----------------------------------------------------------------------===//
+
+#include "serialization/include/ModuleWriter.h"
+#include "serialization/include/ModuleFormat.h"
+#include "serialization/include/ModuleReader.h"
+#include "ast/include/Visitor.h"
+#include "ast/include/Stmt.h"
+#include "ast/include/Expr.h"
+
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <iostream>
+#include <set>
+
+namespace sa {
+
+using namespace serialization;
+
+namespace {
+
+TypeCode encodeType(const Type& type) {
+    switch (type.getKind()) {
+        case TypeKind::Void: return TypeCode::Void;
+        case TypeKind::Str:  return TypeCode::Str;
+        case TypeKind::I64:  return TypeCode::I64;
+        case TypeKind::Bool: return TypeCode::Bool;
+        case TypeKind::Param:  // Generic functions are never exported, and
+        case TypeKind::Struct: // nor are functions taking or returning
+        case TypeKind::Array:  // aggregates.
+        case TypeKind::Slice:
+            break;
+    }
+    return TypeCode::Void;
+}
+
+// Encodes declarations into the binary interface format. Function bodies are
+// encoded into a scratch buffer first: if the body uses a construct the
+// format cannot represent, only the signature is kept.
+class ModuleEncoder : public Visitor {
+public:
+    std::string Out;
+
+    // The functions an importer can call by name: the module's exports,
+    // the exports of its imports and 'print'. A body that calls anything
+    // else, like a helper the module does not export, is not kept.
+    std::set<std::string_view> Callable;
+
+    void emitU8(uint8_t value) { Out.push_back(static_cast<char>(value)); }
+
+    void emitU32(uint32_t value) {
+        char bytes[4];
+        llvm::support::endian::write32le(bytes, value);
+        Out.append(bytes, 4);
+    }
+
+    void emitString(std::string_view str) {
+        emitU32(static_cast<uint32_t>(str.size()));
+        Out.append(str.data(), str.size());
+    }
+
+    void emitFunction(FunctionDecl& decl) {
+        emitString(decl.getName());
+        emitU8(static_cast<uint8_t>(encodeType(decl.getReturnType())));
+        emitU32(static_cast<uint32_t>(decl.getParams().size()));
+        for (const Param& param : decl.getParams()) {
+            emitString(param.Name.lexeme);
+            emitU8(static_cast<uint8_t>(encodeType(param.Ty)));
+        }
+        emitU32(decl.getAttrs());
+
+        std::string body;
+        // Target clones are dispatched at load time, which an importer's
+        // inlined copy would bypass.
+        bool inlineable = !decl.hasAttr(FA_NoInline) && decl.getTargetClones().empty() &&
+                          (decl.hasAttr(FA_Inline) || decl.getBody().size() <= MaxInlineableStmts);
+        if (inlineable) {
+            std::swap(Out, body);
+            Unsupported = false;
+            emitStmts(decl.getBody());
+            std::swap(Out, body);
+            inlineable = !Unsupported;
+        }
+
+        emitU8(inlineable ? FF_HasBody : 0);
+        if (inlineable) {
+            Out += body;
+        }
+    }
+
+private:
+    // Set when a body contains a node the format has no encoding for.
+    bool Unsupported = false;
+
+    // Only reachable through nested declarations, which function bodies
+    // cannot contain today.
+    void visit(FunctionDecl& decl) override { Unsupported = true; }
+    void visit(ImportDecl& decl) override { Unsupported = true; }
+    void visit(StructDecl& decl) override { Unsupported = true; }
+
+    void visit(VarDecl& decl) override {
+        // Declared types may name structs, which interfaces do not carry.
+        if (!decl.getDeclaredType().isVoid()) {
+            Unsupported = true;
+            return;
+        }
+        emitString(decl.getName());
+        decl.getInitializer()->accept(*this);
+    }
+
+    void visit(DeclStmt& stmt) override {
+        emitU8(static_cast<uint8_t>(StmtCode::Let));
+        stmt.getDecl()->accept(*this);
+    }
+
+    void visit(ExprStmt& stmt) override {
+        emitU8(static_cast<uint8_t>(StmtCode::Expr));
+        stmt.getExpr()->accept(*this);
+    }
+
+    void visit(StringLiteralExpr& expr) override {
+        emitU8(static_cast<uint8_t>(ExprCode::StringLiteral));
+        emitString(expr.getLexeme());
+    }
+
+    void visit(VariableExpr& expr) override {
+        emitU8(static_cast<uint8_t>(ExprCode::Variable));
+        emitString(expr.getName());
+    }
+
+    void visit(ReturnStmt& stmt) override {
+        emitU8(static_cast<uint8_t>(StmtCode::Return));
+        emitU8(stmt.getValue() != nullptr);
+        if (stmt.getValue()) {
+            stmt.getValue()->accept(*this);
+        }
+    }
+
+    void visit(IfStmt& stmt) override {
+        emitU8(static_cast<uint8_t>(StmtCode::If));
+        stmt.getCond()->accept(*this);
+        emitStmts(stmt.getThen());
+        emitStmts(stmt.getElse());
+    }
+
+    void emitStmts(const std::vector<std::unique_ptr<Stmt>>& stmts) {
+        emitU32(static_cast<uint32_t>(stmts.size()));
+        for (const auto& stmt : stmts) {
+            stmt->accept(*this);
+        }
+    }
+
+    void visit(IntegerLiteralExpr& expr) override {
+        emitU8(static_cast<uint8_t>(ExprCode::IntegerLiteral));
+        emitString(expr.getLexeme());
+    }
+
+    void visit(BoolLiteralExpr& expr) override {
+        emitU8(static_cast<uint8_t>(ExprCode::BoolLiteral));
+        emitU8(expr.getValue());
+    }
+
+    void visit(BinaryExpr& expr) override {
+        emitU8(static_cast<uint8_t>(ExprCode::Binary));
+        emitString(expr.getOpSpelling());
+        expr.getLHS()->accept(*this);
+        expr.getRHS()->accept(*this);
+    }
+
+    // Bodies that run tasks are not inlined across modules.
+    void visit(SpawnStmt& stmt) override { Unsupported = true; }
+    void visit(JoinStmt& stmt) override { Unsupported = true; }
+    void visit(RegionStmt& stmt) override { Unsupported = true; }
+
+    // Assignments, loops and aggregates are not part of the format yet.
+    void visit(AssignStmt& stmt) override { Unsupported = true; }
+    void visit(StructLiteralExpr& expr) override { Unsupported = true; }
+    void visit(FieldExpr& expr) override { Unsupported = true; }
+    void visit(IndexExpr& expr) override { Unsupported = true; }
+    void visit(SliceExpr& expr) override { Unsupported = true; }
+    void visit(WhileStmt& stmt) override { Unsupported = true; }
+    void visit(ForStmt& stmt) override { Unsupported = true; }
+    void visit(AwaitExpr& expr) override { Unsupported = true; }
+
+    void visit(CallExpr& expr) override {
+        if (!Callable.count(expr.getCalleeName())) {
+            Unsupported = true;
+        }
+        emitU8(static_cast<uint8_t>(ExprCode::Call));
+        emitString(expr.getCalleeName());
+        emitU32(static_cast<uint32_t>(expr.getArgs().size()));
+        for (const auto& arg : expr.getArgs()) {
+            arg->accept(*this);
+        }
+    }
+};
+
+} // namespace
+
+bool writeModuleInterface(const std::vector<std::unique_ptr<Decl>>& ast,
+                          std::string_view moduleName,
+                          const std::string& path) {
+    std::vector<ImportDecl*> imports;
+    std::vector<FunctionDecl*> exports;
+    for (const auto& decl : ast) {
+        if (auto* import = dynamic_cast<ImportDecl*>(decl.get())) {
+            imports.push_back(import);
+        } else if (auto* fn = dynamic_cast<FunctionDecl*>(decl.get())) {
+            if (fn->isExported()) {
+                exports.push_back(fn);
+            }
+        }
+    }
+
+    ModuleEncoder encoder;
+    encoder.Callable.insert("print");
+    for (FunctionDecl* fn : exports) {
+        encoder.Callable.insert(fn->getName());
+    }
+    for (ImportDecl* import : imports) {
+        if (import->getModule()) {
+            for (const auto& fn : import->getModule()->getFunctions()) {
+                encoder.Callable.insert(fn->getName());
+            }
+        }
+    }
+    encoder.Out.append(ModuleMagic, sizeof(ModuleMagic));
+    encoder.emitU32(ModuleVersion);
+    encoder.emitString(moduleName);
+
+    // Bodies kept for inlining may call into our own imports, so importers
+    // need to load those too.
+    encoder.emitU32(static_cast<uint32_t>(imports.size()));
+    for (ImportDecl* import : imports) {
+        encoder.emitString(import->getName());
+    }
+
+    encoder.emitU32(static_cast<uint32_t>(exports.size()));
+    for (FunctionDecl* fn : exports) {
+        encoder.emitFunction(*fn);
+    }
+
+    std::error_code EC;
+    llvm::raw_fd_ostream OS(path, EC, llvm::sys::fs::OF_None);
+    if (EC) {
+        std::cerr << "Error: Could not write module interface '" << path
+                  << "': " << EC.message() << std::endl;
+        return false;
+    }
+    OS << encoder.Out;
+    return true;
+}
+
+} // namespace sa
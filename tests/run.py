@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Compiles the programs in this directory with sac and checks their output.
+
+Each test is a directory holding main.sa and what it must produce:
+- expected.txt: what the program prints, on stdout and stderr. If it
+  fails, a last line "exit status N" or "killed by signal N" follows.
+- expected-sac.txt: what sac prints while compiling main.sa. A test with
+  only this file checks a program sac rejects; it is not linked or run.
+- flags.txt: the sac options to compile main.sa with, one set per line.
+  The sets are different ways of compiling the same program: each must
+  emit the same LLVM IR, print what expected-sac.txt says, and build a
+  program that prints expected.txt. A set may pick the --emit kind: the
+  runner assembles 'asm' with the C compiler and compiles 'llvm-ir' and
+  'llvm-bc' with llc, or skips them without one. A set with
+  --runtime=minimal is linked statically with the minimal runtime instead
+  of the C library, or skipped where there is none.
+Programs with async functions are only run on Linux, the only system
+with an event loop for them.
+Any other .sa file in the directory is a module that main.sa imports: it
+is compiled first, together with its interface, and linked into the
+program.
+
+Usually run through ctest, which passes the paths of the freshly built sac
+and runtime:
+
+    ctest --test-dir build
+"""
+
+import argparse
+import os
+import subprocess
+import sys
+
+TESTS_DIR = os.path.dirname(os.path.abspath(__file__))
+
+# What sac writes for each --emit kind, which the C compiler links.
+EMIT_EXTENSIONS = {"obj": ".o", "asm": ".s", "llvm-ir": ".ll", "llvm-bc": ".bc"}
+
+
+def tests():
+    return sorted(d for d in os.listdir(TESTS_DIR)
+                  if os.path.exists(os.path.join(TESTS_DIR, d, "main.sa")))
+
+
+def run_checked(args):
+    result = subprocess.run(args, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if result.returncode != 0:
+        sys.exit("error: '%s' failed:\n%s" % (" ".join(args), result.stdout))
+    return result.stdout
+
+
+def read_optional(path):
+    if not os.path.exists(path):
+        return None
+    with open(path) as f:
+        return f.read()
+
+
+class Failure(Exception):
+    pass
+
+
+class Skipped(Exception):
+    pass
+
+
+def check(what, expected, got):
+    if got != expected:
+        raise Failure("%s\n--- expected\n%s--- got\n%s" % (what, expected, got))
+
+
+def build_modules(name, args):
+    """Compiles the modules of a test; returns their objects."""
+    source_dir = os.path.join(TESTS_DIR, name)
+    build_dir = os.path.join(args.build_dir, name)
+    objects = []
+    for source in sorted(os.listdir(source_dir)):
+        if not source.endswith(".sa") or source == "main.sa":
+            continue
+        module = source[:-3]
+        objects.append(os.path.join(build_dir, module + ".o"))
+        run_checked(args.sac_command + ["-I", build_dir, "--emit=obj", "-o", objects[-1],
+                                        "--emit-interface=" + os.path.join(build_dir, module + ".sai"),
+                                        os.path.join(source_dir, source)])
+    return objects
+
+
+def run_variant(name, index, flags, modules, args):
+    """Compiles main.sa with 'flags', then links and runs it if the test
+    expects output. Returns the IR sac emits with these flags."""
+    source_dir = os.path.join(TESTS_DIR, name)
+    build_dir = os.path.join(args.build_dir, name)
+    main = os.path.join(source_dir, "main.sa")
+    sac = args.sac_command + ["-I", build_dir] + flags
+    expected_sac = read_optional(os.path.join(source_dir, "expected-sac.txt"))
+    expected = read_optional(os.path.join(source_dir, "expected.txt"))
+    what = "with '%s'" % " ".join(flags) if flags else "without flags"
+
+    emit = "obj"
+    for flag in flags:
+        if flag.startswith("--emit="):
+            emit = flag[len("--emit="):]
+    if emit in ("llvm-ir", "llvm-bc") and not args.llc:
+        raise Skipped("compiling --emit=%s needs --llc" % emit)
+    output = os.path.join(build_dir, "main%d%s" % (index, EMIT_EXTENSIONS[emit]))
+    result = subprocess.run(sac + ["--emit=" + emit, "-o", output, main],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    if expected_sac is not None:
+        check("sac's output " + what, expected_sac, result.stdout)
+    if expected is None:
+        return None
+    if result.returncode != 0:
+        raise Failure("sac failed %s:\n%s" % (what, result.stdout))
+    minimal = "--runtime=minimal" in flags
+    if minimal and not args.runtime_minimal:
+        raise Skipped("--runtime=minimal needs --runtime-minimal")
+    with open(main) as f:
+        if "async fn" in f.read() and not sys.platform.startswith("linux"):
+            raise Skipped("async functions need the event loop, which is Linux only")
+
+    obj = output
+    if emit in ("llvm-ir", "llvm-bc"):
+        obj = os.path.join(build_dir, "main%d.o" % index)
+        run_checked([args.llc, "-filetype=obj", "-relocation-model=pic", "-o", obj, output])
+
+    exe = os.path.join(build_dir, "%s%d.exe" % (name, index))
+    if minimal:
+        run_checked([args.cc, "-nostdlib", "-static", "-Wl,--gc-sections", "-Wl,-z,noexecstack"]
+                    + modules + [obj, args.runtime_minimal, "-o", exe])
+    else:
+        run_checked([args.cc] + modules + [obj, args.runtime, "-lpthread", "-o", exe])
+    result = subprocess.run([exe], stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+    output = result.stdout
+    if result.returncode < 0:
+        output += "killed by signal %d\n" % -result.returncode
+    elif result.returncode > 0:
+        output += "exit status %d\n" % result.returncode
+    check("the output " + what, expected, output)
+    return subprocess.run(sac + ["--emit=llvm-ir", "-o", "-", main], stdout=subprocess.PIPE,
+                          stderr=subprocess.DEVNULL, text=True).stdout
+
+
+def run_test(name, args):
+    source_dir = os.path.join(TESTS_DIR, name)
+    os.makedirs(os.path.join(args.build_dir, name), exist_ok=True)
+    flags_file = read_optional(os.path.join(source_dir, "flags.txt"))
+    variants = [line.split() for line in flags_file.splitlines()] if flags_file else [[]]
+
+    modules = build_modules(name, args)
+    first = None
+    skipped = []
+    for index, flags in enumerate(variants):
+        try:
+            ir = run_variant(name, index, flags, modules, args)
+        except Skipped as reason:
+            skipped.append(str(reason))
+            continue
+        if first is None:
+            first = (flags, ir)
+        elif ir != first[1]:
+            raise Failure("the IR with '%s' differs from the IR with '%s'"
+                          % (" ".join(flags), " ".join(first[0])))
+    return skipped
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--sac", required=True, help="the sac executable")
+    parser.add_argument("--runtime", required=True, help="libsa_runtime.a")
+    parser.add_argument("--runtime-minimal",
+                        help="libsa_runtime_minimal.a, for tests of --runtime=minimal")
+    parser.add_argument("--cc", default="cc", help="the C compiler that links (default: cc)")
+    parser.add_argument("--llc", help="llc, for tests of --emit=llvm-ir and llvm-bc")
+    parser.add_argument("--build-dir", default="tests-build", help="where to put the executables")
+    parser.add_argument("test", nargs="*", help="the tests to run (default: all)")
+    args = parser.parse_args()
+
+    # sac targets macOS unless told otherwise; compile for what the C
+    # compiler targets, which is what the executables are linked for.
+    triple = subprocess.run([args.cc, "-dumpmachine"], stdout=subprocess.PIPE,
+                            text=True, check=True).stdout.strip()
+    args.sac_command = [args.sac, "--target=" + triple]
+
+    failed = []
+    for name in args.test or tests():
+        try:
+            skipped = run_test(name, args)
+            print("PASS %s%s" % (name, "".join("; skipped: " + reason for reason in skipped)))
+        except Failure as failure:
+            print("FAIL %s: %s" % (name, failure))
+            failed.append(name)
+    if failed:
+        sys.exit("error: %d test(s) failed: %s" % (len(failed), " ".join(failed)))
+
+
+if __name__ == "__main__":
+    main()